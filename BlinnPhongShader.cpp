@@ -114,7 +114,44 @@ void BlinnPhongShader::vertexShader(Vertex& vertex)
 {
     vertex.worldSpacePos = Coord3D(m_modelTransformation  * Coord4D(vertex.worldSpacePos, 1.f)); // 模型变换
     vertex.clipSpacePos = m_projectionTransformation * m_viewTransformation * Coord4D(vertex.worldSpacePos, 1.f);
-    vertex.normal = glm::mat3(glm::transpose(glm::inverse(m_modelTransformation))) * vertex.normal;
+    vertex.normal = m_normalTransformation * vertex.normal;
+}
+
+// 用矩阵第 row 行对8个点(x, y, z, 1)做变换：m[0][row] * x + m[1][row] * y + m[2][row] * z + m[3][row]
+static inline __m256 transformRowSimd(const glm::mat4& m, int row, const __m256& x, const __m256& y, const __m256& z)
+{
+    __m256 res = _mm256_fmadd_ps(_mm256_set1_ps(m[0][row]), x, _mm256_set1_ps(m[3][row]));
+    res = _mm256_fmadd_ps(_mm256_set1_ps(m[1][row]), y, res);
+    return _mm256_fmadd_ps(_mm256_set1_ps(m[2][row]), z, res);
+}
+
+void BlinnPhongShader::vertexShaderSIMD(SimdVertex& vertex_simd)
+{
+    // 模型变换
+    SimdVector3D modelPos = vertex_simd.worldSpacePos;
+    vertex_simd.worldSpacePos.x = transformRowSimd(m_modelTransformation, 0, modelPos.x, modelPos.y, modelPos.z);
+    vertex_simd.worldSpacePos.y = transformRowSimd(m_modelTransformation, 1, modelPos.x, modelPos.y, modelPos.z);
+    vertex_simd.worldSpacePos.z = transformRowSimd(m_modelTransformation, 2, modelPos.x, modelPos.y, modelPos.z);
+
+    // 视图投影变换
+    const SimdVector3D& world = vertex_simd.worldSpacePos;
+    vertex_simd.clipSpacePos.x = transformRowSimd(m_viewProjectionTransformation, 0, world.x, world.y, world.z);
+    vertex_simd.clipSpacePos.y = transformRowSimd(m_viewProjectionTransformation, 1, world.x, world.y, world.z);
+    vertex_simd.clipSpacePos.z = transformRowSimd(m_viewProjectionTransformation, 2, world.x, world.y, world.z);
+    vertex_simd.clipSpacePos.w = transformRowSimd(m_viewProjectionTransformation, 3, world.x, world.y, world.z);
+
+    // 法线变换(法线矩阵每次绘制只计算一次)
+    SimdVector3D normal = vertex_simd.normal;
+    const glm::mat3& n = m_normalTransformation;
+    auto transformNormalRow = [&](int row) -> __m256
+    {
+        __m256 res = _mm256_mul_ps(_mm256_set1_ps(n[0][row]), normal.x);
+        res = _mm256_fmadd_ps(_mm256_set1_ps(n[1][row]), normal.y, res);
+        return _mm256_fmadd_ps(_mm256_set1_ps(n[2][row]), normal.z, res);
+    };
+    vertex_simd.normal.x = transformNormalRow(0);
+    vertex_simd.normal.y = transformNormalRow(1);
+    vertex_simd.normal.z = transformNormalRow(2);
 }
 
 void BlinnPhongShader::fragmentShader(Fragment& fragment)
@@ -124,10 +161,10 @@ void BlinnPhongShader::fragmentShader(Fragment& fragment)
     auto& rendererDevice = SRendererDevice::getInstance();
     if(SHADERTEXTURE){
         if(m_material.diffuse != -1){
-            diffuseColor = rendererDevice.m_textureList[m_material.diffuse].sample2D(fragment.texCoord);
+            diffuseColor = rendererDevice.m_textureList[m_material.diffuse].sample2D(fragment.texCoord, fragment.texCoordDx, fragment.texCoordDy, rendererDevice.m_textureFilter);
         }
         if(m_material.specular != -1){
-            specularColor = rendererDevice.m_textureList[m_material.specular].sample2D(fragment.texCoord);
+            specularColor = rendererDevice.m_textureList[m_material.specular].sample2D(fragment.texCoord, fragment.texCoordDx, fragment.texCoordDy, rendererDevice.m_textureFilter);
         }
     }
 
@@ -167,7 +204,7 @@ void BlinnPhongShader::fragmentShader(Fragment& fragment)
 }
 
 
-void BlinnPhongShader::fragmentShaderSIMD(SimdFragment& frag_simd, __m256& final_mask)
+void BlinnPhongShader::fragmentShaderSIMD(SimdFragment& frag_simd, __m256& final_mask) // 输入的属性须已完成透视校正，结果与 fragmentShader 一致
 {
     SimdColor diffuseColor = {_mm256_set1_ps(0.5),
                               _mm256_set1_ps(0.5),
@@ -177,47 +214,35 @@ void BlinnPhongShader::fragmentShaderSIMD(SimdFragment& frag_simd, __m256& final
                                _mm256_set1_ps(0.2),
                                _mm256_set1_ps(0.2)};
 
-    SimdMaterial simdMaterial = {_mm256_set1_ps(m_material.shininess),
-                                 _mm256_set1_epi32(m_material.diffuse),
-                                 _mm256_set1_epi32(m_material.specular)};
-
-    __m256 w = _mm256_rcp_ps(frag_simd.viewDepth);
     auto& renderDevice = SRendererDevice::getInstance();
-    if(SHADERTEXTURE){
-        __m256i negOne = _mm256_set1_epi32(-1);
-        __m256 diffTextureMask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(simdMaterial.diffTextureIdx, negOne));
-        __m256 specTextureMask = _mm256_castsi256_ps(_mm256_cmpgt_epi32(simdMaterial.specTextureIdx, negOne));
-
-        __m256 diffTextureMaskFinal = _mm256_and_ps(final_mask, diffTextureMask);
-        __m256 specTextureMaskFinal = _mm256_and_ps(final_mask, specTextureMask);
-
-        SimdVector2D corrected_texCoord = {
-            _mm256_mul_ps(frag_simd.texCoord.x, w),
-            _mm256_mul_ps(frag_simd.texCoord.y, w)
+    if(SHADERTEXTURE && (m_material.diffuse != -1 || m_material.specular != -1)){
+        // 未通过测试的像素坐标可能无效，置零后再采样
+        SimdVector2D texCoord = {
+            _mm256_and_ps(frag_simd.texCoord.x, final_mask),
+            _mm256_and_ps(frag_simd.texCoord.y, final_mask)
         };
-
-        if(_mm256_movemask_ps(diffTextureMaskFinal) != 0){
-            Texture& diffTexture = renderDevice.m_textureList[m_material.diffuse];
-            SimdColor sampleDiffColor = diffTexture.simdSample2D(corrected_texCoord);
-
-            diffuseColor.r = _mm256_blendv_ps(diffuseColor.r, sampleDiffColor.r, diffTextureMaskFinal);
-            diffuseColor.g = _mm256_blendv_ps(diffuseColor.g, sampleDiffColor.g, diffTextureMaskFinal);
-            diffuseColor.b = _mm256_blendv_ps(diffuseColor.b, sampleDiffColor.b, diffTextureMaskFinal);
+        SimdVector2D texCoordDx = {
+            _mm256_and_ps(frag_simd.texCoordDx.x, final_mask),
+            _mm256_and_ps(frag_simd.texCoordDx.y, final_mask)
+        };
+        SimdVector2D texCoordDy = {
+            _mm256_and_ps(frag_simd.texCoordDy.x, final_mask),
+            _mm256_and_ps(frag_simd.texCoordDy.y, final_mask)
+        };
+        if(m_material.diffuse != -1){
+            diffuseColor = renderDevice.m_textureList[m_material.diffuse].simdSample2D(texCoord, texCoordDx, texCoordDy, renderDevice.m_textureFilter);
         }
-        if(_mm256_movemask_ps(specTextureMaskFinal) != 0){
-            Texture& specTexture = renderDevice.m_textureList[m_material.specular];
-            SimdColor sampleSpecColor = specTexture.simdSample2D(corrected_texCoord);
-
-            specularColor.r = _mm256_blendv_ps(specularColor.r, sampleSpecColor.r, specTextureMaskFinal);
-            specularColor.g = _mm256_blendv_ps(specularColor.g, sampleSpecColor.g, specTextureMaskFinal);
-            specularColor.b = _mm256_blendv_ps(specularColor.b, sampleSpecColor.b, specTextureMaskFinal);
+        if(m_material.specular != -1){
+            specularColor = renderDevice.m_textureList[m_material.specular].simdSample2D(texCoord, texCoordDx, texCoordDy, renderDevice.m_textureFilter);
         }
     }
 
     SimdVector3D normal = simd_normalize_ps(frag_simd.normal);
     SimdVector3D simdEyes = {_mm256_set1_ps(m_eyePos.x), _mm256_set1_ps(m_eyePos.y), _mm256_set1_ps(m_eyePos.z)};
     SimdVector3D viewDir = simd_normalize_ps(simd_sub_ps(simdEyes, frag_simd.worldSpacePos));
-    SimdColor simdResult = {_mm256_set1_ps(0.f), _mm256_set1_ps(0.f), _mm256_set1_ps(0.f)};
+    __m256 simdShininess = _mm256_set1_ps(m_material.shininess);
+    __m256 zero = _mm256_setzero_ps();
+    SimdColor simdResult = {zero, zero, zero};
     for(const auto& light : m_lightList){
         SimdColor simdLightAmbient = {_mm256_set1_ps(light.ambient.x),
                                  _mm256_set1_ps(light.ambient.y),
@@ -228,32 +253,50 @@ void BlinnPhongShader::fragmentShaderSIMD(SimdFragment& frag_simd, __m256& final
         SimdColor simdLightSpecular = {_mm256_set1_ps(light.specular.x),
                                   _mm256_set1_ps(light.specular.y),
                                   _mm256_set1_ps(light.specular.z)};
-        SimdVector3D lightPos = {_mm256_set1_ps(light.pos.x),
-                                 _mm256_set1_ps(light.pos.y),
-                                 _mm256_set1_ps(light.pos.z)};
 
-        SimdVector3D lightDir = simd_normalize_ps(simd_sub_ps(lightPos, frag_simd.worldSpacePos));
+        SimdVector3D lightDir;
+        if(light.pos.w != 0.f){ // 点光源
+            SimdVector3D lightPos = {_mm256_set1_ps(light.pos.x),
+                                     _mm256_set1_ps(light.pos.y),
+                                     _mm256_set1_ps(light.pos.z)};
+            lightDir = simd_normalize_ps(simd_sub_ps(lightPos, frag_simd.worldSpacePos));
+        }
+        else{ // 平行光
+            lightDir = {_mm256_set1_ps(-light.dir.x),
+                        _mm256_set1_ps(-light.dir.y),
+                        _mm256_set1_ps(-light.dir.z)};
+        }
 
         //ambient
         SimdColor ambient = simd_mul_ps(simdLightAmbient, diffuseColor);
 
         //diffuse
-        __m256 dotNormalLight = simd_dot_ps(normal, lightDir);
-        __m256 maxDotZero = simd_max_ps(dotNormalLight, _mm256_setzero_ps());
+        __m256 maxDotZero = simd_max_ps(simd_dot_ps(normal, lightDir), zero);
         SimdColor diffuse = simd_scalar_mul_ps(simd_mul_ps(simdLightDiffuse, diffuseColor), maxDotZero);
 
         //specular
         SimdVector3D halfVec = simd_normalize_ps(simd_add_ps(viewDir, lightDir));
-        __m256 dotNormalHalf = simd_dot_ps(normal, halfVec);
-        __m256 maxDotHalfZero = simd_max_ps(dotNormalHalf, _mm256_setzero_ps());
-        // __m256 simdShininess = simdMaterial.shininess;
-
-        __m256 specularIntensity = _mm256_sub_ps(maxDotHalfZero, _mm256_set1_ps(0.03f));
+        __m256 maxDotHalfZero = simd_max_ps(simd_dot_ps(normal, halfVec), zero);
+        __m256 specularIntensity = simd_pow_ps(maxDotHalfZero, simdShininess);
         SimdColor specular = simd_scalar_mul_ps(simd_mul_ps(simdLightSpecular, specularColor), specularIntensity);
 
-        simdResult = simd_add_ps(simdResult, ambient);
-        simdResult = simd_add_ps(simdResult, diffuse);
-        // simdResult = simd_add_ps(simdResult, specular);
+        if(AMBIENT){
+            simdResult = simd_add_ps(simdResult, ambient);
+        }
+        else if(DIFFUSE){
+            simdResult = simd_add_ps(simdResult, diffuse);
+        }
+        else if(SPECULAR){
+            simdResult = simd_add_ps(simdResult, specular);
+        }
+        else{
+            simdResult = simd_add_ps(simdResult, ambient);
+            simdResult = simd_add_ps(simdResult, diffuse);
+            simdResult = simd_add_ps(simdResult, specular);
+        }
     }
-    frag_simd.fragmentColor = simdResult;
+    __m256 one = _mm256_set1_ps(1.f);
+    frag_simd.fragmentColor = {simd_clamp_ps(simdResult.r, zero, one),
+                               simd_clamp_ps(simdResult.g, zero, one),
+                               simd_clamp_ps(simdResult.b, zero, one)};
 }
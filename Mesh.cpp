@@ -1,4 +1,6 @@
 #include "Mesh.h"
+#include <algorithm>
+#include <cmath>
 
 Mesh::Mesh()
     :m_normalTextureIndex(-1)
@@ -7,15 +9,54 @@ Mesh::Mesh()
 {
 }
 
+void Mesh::computeBounds()
+{
+    if(m_vertices.empty()){
+        return;
+    }
+    m_aabbMin = m_aabbMax = m_vertices[0].worldSpacePos;
+    for(const Vertex& vertex : m_vertices){
+        m_aabbMin = glm::min(m_aabbMin, vertex.worldSpacePos);
+        m_aabbMax = glm::max(m_aabbMax, vertex.worldSpacePos);
+    }
+    // 球心取 AABB 中心，半径取到最远顶点的距离，比半对角线更紧
+    m_boundingCentre = (m_aabbMin + m_aabbMax) * 0.5f;
+    float radius2 = 0.f;
+    for(const Vertex& vertex : m_vertices){
+        Vector3D offset = vertex.worldSpacePos - m_boundingCentre;
+        radius2 = std::max(radius2, glm::dot(offset, offset));
+    }
+    m_boundingRadius = std::sqrt(radius2);
+}
+
 void Mesh::draw()
 {
-    SRendererDevice::getInstance().m_vertexList = m_vertices;
-    SRendererDevice::getInstance().m_indices = m_indices;
-    SRendererDevice::getInstance().m_shader->m_material.diffuse = m_diffuseTextureIndex;
-    SRendererDevice::getInstance().m_shader->m_material.specular = m_specularTextureIndex;
-<<<<<<< HEAD
-    SRendererDevice::getInstance().render();
-=======
-    SRendererDevice::getInstance().render();   
->>>>>>> future
+    auto& renderDevice = SRendererDevice::getInstance();
+    if(m_vertexBuffer == INVALID_BUFFER){ // 首次绘制时上传，之后每帧只绑定句柄
+        m_vertexBuffer = renderDevice.createVertexBuffer(std::move(m_vertices));
+        m_indexBuffer = renderDevice.createIndexBuffer(std::move(m_indices));
+        m_vertices.clear();
+        m_indices.clear();
+    }
+    // 整个网格在视锥外时不做任何顶点处理
+    if(m_boundingRadius >= 0.f && !renderDevice.isMeshVisible(m_aabbMin, m_aabbMax, m_boundingCentre, m_boundingRadius)){
+        return;
+    }
+    // 逐 meshlet 剔除后设备的索引只包含剩余的三角形
+    renderDevice.bindVertexBuffer(m_vertexBuffer);
+    if(!renderDevice.cullMeshlets(m_meshlets, m_indexBuffer)){
+        return;
+    }
+    renderDevice.m_shader->m_material.diffuse = m_diffuseTextureIndex;
+    renderDevice.m_shader->m_material.specular = m_specularTextureIndex;
+    renderDevice.render();
+}
+
+void Mesh::releaseBuffers()
+{
+    auto& renderDevice = SRendererDevice::getInstance();
+    renderDevice.releaseVertexBuffer(m_vertexBuffer);
+    renderDevice.releaseIndexBuffer(m_indexBuffer);
+    m_vertexBuffer = INVALID_BUFFER;
+    m_indexBuffer = INVALID_BUFFER;
 }
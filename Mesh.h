@@ -7,23 +7,31 @@
 #include "BasicDataStructure.h"
 
 
-<<<<<<< HEAD
-=======
 extern bool FXAA;
 
->>>>>>> future
 class Mesh
 {
 public:
+    // 导入与优化阶段使用的 CPU 端数据，首次绘制时移交给设备的顶点/索引缓冲，之后为空
     std::vector<Vertex> m_vertices;
     std::vector<unsigned> m_indices;
+    BufferHandle m_vertexBuffer{INVALID_BUFFER};
+    BufferHandle m_indexBuffer{INVALID_BUFFER};
     int m_normalTextureIndex{-1};
     int m_diffuseTextureIndex{-1};
     int m_specularTextureIndex{-1};
+    // 模型空间包围体，由 computeBounds 根据 m_vertices 计算，绘制前用于视锥剔除；半径为负表示尚未计算，不做剔除
+    Coord3D m_aabbMin{0.f};
+    Coord3D m_aabbMax{0.f};
+    Coord3D m_boundingCentre{0.f};
+    float m_boundingRadius{-1.f};
+    std::vector<Meshlet> m_meshlets; // 覆盖全部索引、按三角形顺序排列，为空时整个网格一起提交
 
     Mesh();
     ~Mesh() = default;
+    void computeBounds();
     void draw();
+    void releaseBuffers(); // 释放设备上的缓冲(由持有网格的模型在析构时调用)
 };
 
 #endif // MESH_H
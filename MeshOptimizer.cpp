@@ -0,0 +1,359 @@
+#include "MeshOptimizer.h"
+#include <algorithm>
+#include <array>
+#include <climits>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+MeshOptimizationStats& MeshOptimizationStats::operator+=(const MeshOptimizationStats& other)
+{
+    verticesBefore += other.verticesBefore;
+    verticesAfter += other.verticesAfter;
+    triangles += other.triangles;
+    cacheMissesBefore += other.cacheMissesBefore;
+    cacheMissesAfter += other.cacheMissesAfter;
+    return *this;
+}
+
+namespace {
+
+// 只比较导入得到的输入属性，裁剪/屏幕空间字段在顶点着色时才写入
+using VertexKey = std::array<uint32_t, 8>;
+
+VertexKey makeVertexKey(const Vertex& vertex)
+{
+    const float attributes[8] = {vertex.worldSpacePos.x, vertex.worldSpacePos.y, vertex.worldSpacePos.z,
+                                 vertex.normal.x, vertex.normal.y, vertex.normal.z,
+                                 vertex.texCoord.x, vertex.texCoord.y};
+    VertexKey key;
+    std::memcpy(key.data(), attributes, sizeof(attributes));
+    return key;
+}
+
+struct VertexKeyHash
+{
+    size_t operator()(const VertexKey& key) const
+    {
+        size_t hash = 0;
+        for(uint32_t bits : key){
+            hash ^= bits + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+        }
+        return hash;
+    }
+};
+
+} // namespace
+
+size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+{
+    std::unordered_map<VertexKey, unsigned, VertexKeyHash> unique;
+    unique.reserve(vertices.size());
+    std::vector<unsigned> remap(vertices.size());
+    std::vector<Vertex> welded;
+    welded.reserve(vertices.size());
+    for(size_t i = 0; i < vertices.size(); i++){
+        auto res = unique.emplace(makeVertexKey(vertices[i]), static_cast<unsigned>(welded.size()));
+        if(res.second){
+            welded.push_back(vertices[i]);
+        }
+        remap[i] = res.first->second;
+    }
+    for(unsigned& index : indices){
+        index = remap[index];
+    }
+    vertices.swap(welded);
+    return vertices.size();
+}
+
+void optimizeVertexCache(std::vector<unsigned>& indices, size_t vertexCount, int cacheSize, std::vector<size_t>* clusterStarts)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0){
+        return;
+    }
+    // 顶点 -> 相邻三角形(CSR)，liveTriangles 为尚未输出的相邻三角形数
+    std::vector<unsigned> offsets(vertexCount + 1, 0);
+    for(unsigned index : indices){
+        offsets[index + 1]++;
+    }
+    std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+    std::vector<unsigned> liveTriangles(vertexCount);
+    std::vector<unsigned> adjacency(indices.size());
+    {
+        std::vector<unsigned> fill(offsets.begin(), offsets.end() - 1);
+        for(size_t i = 0; i < indices.size(); i++){
+            adjacency[fill[indices[i]]++] = static_cast<unsigned>(i / 3);
+        }
+        for(size_t v = 0; v < vertexCount; v++){
+            liveTriangles[v] = offsets[v + 1] - offsets[v];
+        }
+    }
+
+    std::vector<unsigned> timestamps(vertexCount, 0);
+    std::vector<char> emitted(triangleCount, 0);
+    std::vector<unsigned> deadEnd; // 最近输出过的顶点，局部邻域走完时优先从这里继续
+    std::vector<unsigned> candidates;
+    std::vector<unsigned> result;
+    result.reserve(indices.size());
+    unsigned timestamp = cacheSize + 1;
+    size_t cursor = 0; // 按输入顺序扫描的位置，死角栈也耗尽时使用
+    long long fanning = indices[0];
+    if(clusterStarts){
+        clusterStarts->assign(1, 0);
+    }
+
+    while(fanning >= 0){
+        candidates.clear();
+        for(unsigned k = offsets[fanning]; k < offsets[fanning + 1]; k++){
+            unsigned triangle = adjacency[k];
+            if(emitted[triangle]){
+                continue;
+            }
+            emitted[triangle] = 1;
+            for(int j = 0; j < 3; j++){
+                unsigned v = indices[3 * triangle + j];
+                result.push_back(v);
+                deadEnd.push_back(v);
+                candidates.push_back(v);
+                liveTriangles[v]--;
+                if(timestamp - timestamps[v] > static_cast<unsigned>(cacheSize)){
+                    timestamps[v] = timestamp++;
+                }
+            }
+        }
+
+        // 下一个扇心：输出完剩余三角形后仍在缓存中、且在缓存里待得最久的候选顶点
+        long long next = -1;
+        int bestPriority = -1;
+        for(unsigned v : candidates){
+            if(liveTriangles[v] == 0){
+                continue;
+            }
+            int priority = 0;
+            if(timestamp - timestamps[v] + 2 * liveTriangles[v] <= static_cast<unsigned>(cacheSize)){
+                priority = timestamp - timestamps[v];
+            }
+            if(priority > bestPriority){
+                bestPriority = priority;
+                next = v;
+            }
+        }
+        if(next < 0){
+            while(!deadEnd.empty() && next < 0){
+                unsigned v = deadEnd.back();
+                deadEnd.pop_back();
+                if(liveTriangles[v] > 0){
+                    next = v;
+                }
+            }
+            while(next < 0 && cursor < vertexCount){
+                if(liveTriangles[cursor] > 0){
+                    next = cursor;
+                }
+                cursor++;
+            }
+            if(next >= 0 && clusterStarts){
+                clusterStarts->push_back(result.size() / 3);
+            }
+        }
+        fanning = next;
+    }
+    indices.swap(result);
+}
+
+void optimizeOverdraw(std::vector<unsigned>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusterStarts)
+{
+    const size_t triangleCount = indices.size() / 3;
+    if(clusterStarts.size() < 2){
+        return;
+    }
+    struct Cluster
+    {
+        size_t begin;
+        size_t end;
+        float sortKey;
+    };
+    // 三角形面积加权的中心与法线
+    auto accumulate = [&](size_t begin, size_t end, Vector3D& centroid, Vector3D& normal) {
+        centroid = Vector3D(0.f);
+        normal = Vector3D(0.f);
+        float area = 0.f;
+        for(size_t t = begin; t < end; t++){
+            const Coord3D& a = vertices[indices[3 * t]].worldSpacePos;
+            const Coord3D& b = vertices[indices[3 * t + 1]].worldSpacePos;
+            const Coord3D& c = vertices[indices[3 * t + 2]].worldSpacePos;
+            Vector3D faceNormal = glm::cross(b - a, c - a);
+            float faceArea = glm::length(faceNormal);
+            centroid += (a + b + c) * (faceArea / 3.f);
+            normal += faceNormal;
+            area += faceArea;
+        }
+        if(area > 0.f){
+            centroid /= area;
+        }
+        float length = glm::length(normal);
+        if(length > 0.f){
+            normal /= length;
+        }
+    };
+
+    Vector3D meshCentroid, meshNormal;
+    accumulate(0, triangleCount, meshCentroid, meshNormal);
+    std::vector<Cluster> clusters;
+    clusters.reserve(clusterStarts.size());
+    for(size_t i = 0; i < clusterStarts.size(); i++){
+        size_t end = i + 1 < clusterStarts.size() ? clusterStarts[i + 1] : triangleCount;
+        Vector3D centroid, normal;
+        accumulate(clusterStarts[i], end, centroid, normal);
+        // 越靠外且越朝外的簇越可能遮挡其他簇，先画
+        clusters.push_back({clusterStarts[i], end, glm::dot(centroid - meshCentroid, normal)});
+    }
+    std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.sortKey > b.sortKey; });
+
+    std::vector<unsigned> result;
+    result.reserve(indices.size());
+    for(const Cluster& cluster : clusters){
+        result.insert(result.end(), indices.begin() + 3 * cluster.begin, indices.begin() + 3 * cluster.end);
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices)
+{
+    std::vector<unsigned> remap(vertices.size(), UINT_MAX);
+    std::vector<Vertex> result;
+    result.reserve(vertices.size());
+    for(unsigned& index : indices){
+        if(remap[index] == UINT_MAX){
+            remap[index] = static_cast<unsigned>(result.size());
+            result.push_back(vertices[index]);
+        }
+        index = remap[index];
+    }
+    vertices.swap(result);
+}
+
+size_t simulateVertexCache(const std::vector<unsigned>& indices, size_t vertexCount, int cacheSize)
+{
+    std::vector<unsigned> timestamps(vertexCount, 0);
+    unsigned timestamp = cacheSize + 1;
+    size_t misses = 0;
+    for(unsigned index : indices){
+        if(timestamp - timestamps[index] > static_cast<unsigned>(cacheSize)){
+            timestamps[index] = timestamp++;
+            misses++;
+        }
+    }
+    return misses;
+}
+
+static Meshlet makeMeshlet(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices, size_t firstTriangle, size_t triangleCount)
+{
+    Meshlet meshlet;
+    meshlet.triangleOffset = static_cast<unsigned>(firstTriangle);
+    meshlet.triangleCount = static_cast<unsigned>(triangleCount);
+    const size_t begin = 3 * firstTriangle;
+    const size_t end = 3 * (firstTriangle + triangleCount);
+
+    Coord3D aabbMin = vertices[indices[begin]].worldSpacePos;
+    Coord3D aabbMax = aabbMin;
+    for(size_t i = begin; i < end; i++){
+        aabbMin = glm::min(aabbMin, vertices[indices[i]].worldSpacePos);
+        aabbMax = glm::max(aabbMax, vertices[indices[i]].worldSpacePos);
+    }
+    meshlet.centre = (aabbMin + aabbMax) * 0.5f;
+    float radius2 = 0.f;
+    for(size_t i = begin; i < end; i++){
+        Vector3D offset = vertices[indices[i]].worldSpacePos - meshlet.centre;
+        radius2 = std::max(radius2, glm::dot(offset, offset));
+    }
+    meshlet.radius = std::sqrt(radius2);
+
+    // 法线锥：轴为单位面法线之和的方向，张角由与轴夹角最大的面法线决定
+    std::vector<Vector3D> faceNormals;
+    faceNormals.reserve(triangleCount);
+    Vector3D axis(0.f);
+    for(size_t i = begin; i < end; i += 3){
+        const Coord3D& a = vertices[indices[i]].worldSpacePos;
+        const Coord3D& b = vertices[indices[i + 1]].worldSpacePos;
+        const Coord3D& c = vertices[indices[i + 2]].worldSpacePos;
+        Vector3D normal = glm::cross(b - a, c - a);
+        float length = glm::length(normal);
+        if(length > 0.f){ // 退化三角形不会被光栅化，不影响法线锥
+            faceNormals.push_back(normal / length);
+            axis += faceNormals.back();
+        }
+    }
+    float axisLength = glm::length(axis);
+    meshlet.coneAxis = axisLength > 0.f ? axis / axisLength : Vector3D(0.f, 0.f, 1.f);
+    meshlet.coneCutoff = 1.f;
+    if(axisLength > 0.f){
+        float minDot = 1.f;
+        for(const Vector3D& normal : faceNormals){
+            minDot = std::min(minDot, glm::dot(normal, meshlet.coneAxis));
+        }
+        if(minDot > 0.f){ // 张角超过90度时不剔除
+            meshlet.coneCutoff = std::sqrt(1.f - minDot * minDot);
+        }
+    }
+    return meshlet;
+}
+
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+                                   size_t maxVertices, size_t maxTriangles)
+{
+    std::vector<Meshlet> meshlets;
+    const size_t triangleCount = indices.size() / 3;
+    if(triangleCount == 0 || indices.size() % 3 != 0){
+        return meshlets;
+    }
+    std::vector<unsigned> owner(vertices.size(), UINT_MAX); // 顶点最近一次被计入的 meshlet 序号
+    size_t first = 0;
+    size_t vertexCount = 0;
+    for(size_t t = 0; t < triangleCount; t++){
+        const unsigned current = static_cast<unsigned>(meshlets.size());
+        size_t newVertices = 0;
+        for(int j = 0; j < 3; j++){
+            newVertices += owner[indices[3 * t + j]] != current;
+        }
+        if(vertexCount + newVertices > maxVertices || t - first == maxTriangles){
+            meshlets.push_back(makeMeshlet(vertices, indices, first, t - first));
+            first = t;
+            vertexCount = 0;
+        }
+        const unsigned id = static_cast<unsigned>(meshlets.size());
+        for(int j = 0; j < 3; j++){
+            unsigned& vertexOwner = owner[indices[3 * t + j]];
+            if(vertexOwner != id){
+                vertexOwner = id;
+                vertexCount++;
+            }
+        }
+    }
+    meshlets.push_back(makeMeshlet(vertices, indices, first, triangleCount - first));
+    return meshlets;
+}
+
+MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned>& indices, MeshOptimization level)
+{
+    MeshOptimizationStats stats;
+    stats.verticesBefore = vertices.size();
+    stats.triangles = indices.size() / 3;
+    stats.cacheMissesBefore = simulateVertexCache(indices, vertices.size());
+    // 含点/线图元的网格保持原样
+    if(level != MeshOptimization::NONE && indices.size() % 3 == 0 && !indices.empty()){
+        weldVertices(vertices, indices);
+        std::vector<size_t> clusterStarts;
+        optimizeVertexCache(indices, vertices.size(), MESH_OPT_CACHE_SIZE,
+                            level == MeshOptimization::OVERDRAW ? &clusterStarts : nullptr);
+        if(level == MeshOptimization::OVERDRAW){
+            optimizeOverdraw(indices, vertices, clusterStarts);
+        }
+        optimizeVertexFetch(vertices, indices);
+    }
+    stats.verticesAfter = vertices.size();
+    stats.cacheMissesAfter = simulateVertexCache(indices, vertices.size());
+    return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+
+#include <vector>
+#include "BasicDataStructure.h"
+
+// 导入时的网格优化：焊接相同顶点 -> Tipsify 三角形重排(顶点后变换缓存) -> 可选的遮挡优先排序 -> 按首次使用重排顶点
+enum class MeshOptimization
+{
+    NONE,
+    VERTEX_CACHE, // 焊接 + Tipsify + 顶点重排
+    OVERDRAW      // 在 VERTEX_CACHE 基础上把 Tipsify 得到的簇按“朝外程度”排序，先画外侧，减少被覆盖片元的着色
+};
+
+struct MeshOptimizationStats
+{
+    size_t verticesBefore{0};
+    size_t verticesAfter{0};
+    size_t triangles{0};
+    size_t cacheMissesBefore{0}; // 以 MESH_OPT_CACHE_SIZE 大小的 FIFO 缓存模拟
+    size_t cacheMissesAfter{0};
+
+    double acmrBefore() const { return triangles ? double(cacheMissesBefore) / triangles : 0.0; } // 平均每个三角形的缓存缺失数
+    double acmrAfter() const { return triangles ? double(cacheMissesAfter) / triangles : 0.0; }
+    MeshOptimizationStats& operator+=(const MeshOptimizationStats& other);
+};
+
+constexpr int MESH_OPT_CACHE_SIZE = 16;
+constexpr size_t MESHLET_MAX_VERTICES = 64;
+constexpr size_t MESHLET_MAX_TRIANGLES = 128;
+
+// 按 worldSpacePos/normal/texCoord 逐位比较合并顶点，返回合并后的顶点数
+size_t weldVertices(std::vector<Vertex>& vertices, std::vector<unsigned>& indices);
+// Tipsify(Sander 等, 2007)：围绕缓存中的顶点扇形输出三角形。clusterStarts 非空时记录每次跳出局部邻域的位置(三角形下标)
+void optimizeVertexCache(std::vector<unsigned>& indices, size_t vertexCount, int cacheSize = MESH_OPT_CACHE_SIZE,
+                         std::vector<size_t>* clusterStarts = nullptr);
+// 在簇内顺序不变的前提下按簇的朝外程度降序重排
+void optimizeOverdraw(std::vector<unsigned>& indices, const std::vector<Vertex>& vertices, const std::vector<size_t>& clusterStarts);
+// 顶点按索引中首次出现的顺序重排，未被引用的顶点被丢弃
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned>& indices);
+size_t simulateVertexCache(const std::vector<unsigned>& indices, size_t vertexCount, int cacheSize = MESH_OPT_CACHE_SIZE);
+
+// 按索引顺序贪心地把三角形切成 meshlet(不重排三角形)，并计算每个 meshlet 的包围球与法线锥
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<unsigned>& indices,
+                                   size_t maxVertices = MESHLET_MAX_VERTICES, size_t maxTriangles = MESHLET_MAX_TRIANGLES);
+
+MeshOptimizationStats optimizeMesh(std::vector<Vertex>& vertices, std::vector<unsigned>& indices, MeshOptimization level);
+
+#endif // MESHOPTIMIZER_H
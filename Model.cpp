@@ -1,6 +1,49 @@
 #include "Model.h"
+#include <cstring>
+#include <type_traits>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include "tbb/parallel_for.h"
 
-Model::Model(QString path)
+// 二进制网格缓存(与模型文件同目录的 <模型文件名>.srmesh)：
+// 头部 | 纹理相对路径 | 每个网格的描述 | 各网格的顶点数组(Vertex 原样存储) | 各网格的索引数组
+// 源文件大小或修改时间变化、Vertex 布局变化、优化级别或请求的导入器与本次不同时缓存失效，重新导入
+static constexpr char MESH_CACHE_MAGIC[8] = {'S', 'R', 'M', 'E', 'S', 'H', '0', '1'};
+static constexpr uint32_t MESH_CACHE_VERSION = 4;
+static const char* MESH_CACHE_SUFFIX = ".srmesh";
+
+static_assert(std::is_trivially_copyable<Vertex>::value, "Vertex is stored in the mesh cache with memcpy");
+
+struct MeshCacheHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t vertexSize; // sizeof(Vertex)，结构体变化时缓存自动失效
+    uint32_t optimization; // MeshOptimization
+    uint32_t requestedNativeImporter; // 写入时请求的导入器，用于判断缓存是否有效
+    uint32_t nativeImporter; // 实际使用的导入器，1：原生 OBJ 解析器，0：Assimp(包括原生解析失败后的回退)
+    int64_t sourceSize;
+    int64_t sourceModified; // 源文件修改时间(毫秒)
+    uint32_t meshCount;
+    uint32_t textureCount;
+    int32_t triangleCount;
+    int32_t vertexCount;
+    float bounds[6]; // minX minY minZ maxX maxY maxZ
+    float centre[3];
+    float normalization[16]; // 模型标准化矩阵(列主序)
+};
+
+struct MeshCacheEntry
+{
+    uint32_t vertexCount;
+    uint32_t indexCount;
+    int32_t normalTexture;
+    int32_t diffuseTexture;
+    int32_t specularTexture;
+};
+
+Model::Model(QString path, bool useMeshCache, bool nativeObj, MeshOptimization optimization)
     :m_triangleCount(0)
     ,m_vertexCount(0)
     ,m_loadSuccess(true)
@@ -11,9 +54,22 @@ Model::Model(QString path)
     ,m_maxY(FLT_MIN)
     ,m_maxZ(FLT_MIN)
     ,m_modelNormalizationMatrix(1.f)
+    ,m_optimization(optimization)
+    ,m_requestedNativeImporter(nativeObj && QFileInfo(path).suffix().toLower() == "obj")
+    ,m_nativeImporter(false)
 {
     std::cout << "Model constructor: " << path.toStdString() << std::endl;
-    loadModel(path);
+    // 缓存按请求的导入器匹配：原生解析失败回退到 Assimp 时写入的缓存，下次同样请求原生解析时仍然可用
+    if(useMeshCache && loadMeshCache(path)){
+        std::cout << "mesh cache loaded" << std::endl;
+        computeMeshBounds();
+        return; // 边界、中心与标准化矩阵都来自缓存
+    }
+    loadModel(path, nativeObj);
+    if(m_loadSuccess && m_optimization != MeshOptimization::NONE){
+        optimizeMeshes();
+    }
+    computeMeshBounds();
     if (m_loadSuccess) {
         m_centre = {(m_maxX + m_minX) / 2.f, (m_maxY + m_minY) / 2.f, (m_maxZ + m_minZ) / 2.f};
     }
@@ -35,6 +91,9 @@ Model::Model(QString path)
         m_modelNormalizationMatrix = scaleMatrix * translationMatrix; // 先平移再缩放
         m_centre = m_modelNormalizationMatrix * Vector4D(m_centre, 1.f);
     }
+    if(useMeshCache && m_loadSuccess){
+        saveMeshCache(path);
+    }
 }
 
 float Model::getYRange()
@@ -53,23 +112,40 @@ float Model::getYRange()
 
 }
 
+Model::~Model()
+{
+    for(auto& mesh : m_meshes){
+        mesh.releaseBuffers();
+    }
+    for(BufferHandle handle : m_textureHandles){
+        SRendererDevice::getInstance().releaseTexture(handle);
+    }
+}
+
 void Model::draw()
 {
-    SRendererDevice::getInstance().m_textureList = m_textureList;
+    if(!m_textureList.empty()){
+        uploadTextures();
+    }
     for(int i = 0; i < m_meshes.size(); i++){
         m_meshes[i].draw();
     }
-<<<<<<< HEAD
-=======
     // if(FXAA)
     // SRendererDevice::getInstance().m_shader->FXAAShader(SRendererDevice::getInstance().getFrameBuffer().getImage(), 0.0833f, 0.75f, 0.0312f);
->>>>>>> future
 }
 
 //====================================================================
 
-void Model::loadModel(QString path)
+void Model::loadModel(QString path, bool nativeObj)
 {
+    if(nativeObj && QFileInfo(path).suffix().toLower() == "obj"){
+        if(loadObjModel(path)){
+            m_nativeImporter = true;
+            return;
+        }
+        std::cout << "Native OBJ loader failed, falling back to Assimp: " << path.toStdString() << std::endl;
+    }
+
     Assimp::Importer import;
     // 对加载的模型进行标准化，包括将QString转换成标准字符串
     // aiProcess_Triangulate，将多边形转换成三角形
@@ -91,6 +167,7 @@ void Model::loadModel(QString path)
     // 传入场景根节点和场景指针
     // 调用节点处理函数，从根节点处理模型
     processNode(scene->mRootNode, scene);
+    resolveTextures(); // 网格处理完后再等待纹理解码完成
     std::cout << "model load success" << std::endl;
 }
 
@@ -181,20 +258,268 @@ int Model::loadMaterialTextures(Mesh &mesh, aiMaterial *mat, aiTextureType type)
     {
         aiString str;
         mat->GetTexture(type, 0, &str);
-        QString path = m_directory + '/' + str.C_Str();
-        for(int i = 0; i < m_textureList.size(); i++)
-        {
-            if(m_textureList[i].m_path == path){return i;}
+        return requestTexture(m_directory + '/' + str.C_Str());
+    }
+    return -1;
+}
+
+int Model::requestTexture(const QString& path)
+{
+    auto it = m_textureIndex.find(path.toStdString());
+    if(it != m_textureIndex.end()){return it->second;}
+    // 解码交给纹理缓存的工作线程，这里先分配下标，继续处理后面的网格
+    int index = (int)m_pendingTextures.size();
+    m_pendingTextures.push_back(TextureCache::getInstance().load(path, SRendererDevice::getInstance().m_textureLayout));
+    m_textureIndex.emplace(path.toStdString(), index);
+    return index;
+}
+
+bool Model::loadObjModel(const QString& path)
+{
+    ObjLoader loader;
+    if(!loader.load(path)){
+        return false;
+    }
+    std::cout << "OBJ loaded. Number of materials:" << loader.m_materials.size() << std::endl;
+    m_directory = path.mid(0, path.lastIndexOf('/'));
+    for(ObjMesh& objMesh : loader.m_meshes){
+        Mesh res;
+        for(const Vertex& vertex : objMesh.vertices){
+            m_minX = std::min(m_minX, vertex.worldSpacePos.x);
+            m_minY = std::min(m_minY, vertex.worldSpacePos.y);
+            m_minZ = std::min(m_minZ, vertex.worldSpacePos.z);
+            m_maxX = std::max(m_maxX, vertex.worldSpacePos.x);
+            m_maxY = std::max(m_maxY, vertex.worldSpacePos.y);
+            m_maxZ = std::max(m_maxZ, vertex.worldSpacePos.z);
         }
-        Texture texture;
-        if(texture.loadFromImage(path))
-        {
-            qDebug() << path;
+        m_vertexCount += objMesh.vertices.size();
+        m_triangleCount += objMesh.indices.size() / 3;
+        res.m_vertices = std::move(objMesh.vertices);
+        res.m_indices = std::move(objMesh.indices);
+
+        // 贴图路径与 Assimp 一样按 MTL 中的写法拼在模型目录后
+        auto material = loader.m_materials.find(objMesh.material);
+        if(material != loader.m_materials.end()){
+            const ObjMaterial& mtl = material->second;
+            res.m_normalTextureIndex = mtl.bumpMap.isEmpty() ? -1 : requestTexture(m_directory + '/' + mtl.bumpMap);
+            res.m_diffuseTextureIndex = mtl.diffuseMap.isEmpty() ? -1 : requestTexture(m_directory + '/' + mtl.diffuseMap);
+            res.m_specularTextureIndex = mtl.specularMap.isEmpty() ? -1 : requestTexture(m_directory + '/' + mtl.specularMap);
+        }
+        m_meshes.push_back(std::move(res));
+    }
+    resolveTextures();
+    return true;
+}
+
+void Model::resolveTextures()
+{
+    // 等待所有纹理解码完成；解码失败的纹理从列表中去掉，并把网格中对应的下标置为 -1
+    std::vector<int> remap(m_pendingTextures.size(), -1);
+    for(size_t i = 0; i < m_pendingTextures.size(); i++){
+        const Texture& texture = m_pendingTextures[i].get();
+        if(texture.isLoaded()){
+            qDebug() << texture.m_path;
+            remap[i] = (int)m_textureList.size();
             m_textureList.push_back(texture);
-            return (int)m_textureList.size() - 1;
         }
     }
-    return -1;
+    for(auto& mesh : m_meshes){
+        for(int* index : {&mesh.m_normalTextureIndex, &mesh.m_diffuseTextureIndex, &mesh.m_specularTextureIndex}){
+            *index = *index >= 0 ? remap[*index] : -1;
+        }
+    }
+    m_pendingTextures.clear();
+    m_textureIndex.clear();
+}
+
+void Model::uploadTextures()
+{
+    // 纹理下标从模型内的序号改为设备句柄，之后的绘制不再拷贝纹理列表
+    for(Texture& texture : m_textureList){
+        m_textureHandles.push_back(SRendererDevice::getInstance().createTexture(std::move(texture)));
+    }
+    for(auto& mesh : m_meshes){
+        for(int* index : {&mesh.m_normalTextureIndex, &mesh.m_diffuseTextureIndex, &mesh.m_specularTextureIndex}){
+            *index = *index >= 0 ? m_textureHandles[*index] : -1;
+        }
+    }
+    m_textureList.clear();
+}
+
+void Model::computeMeshBounds()
+{
+    tbb::parallel_for(size_t(0), m_meshes.size(), [&](size_t i) {
+        m_meshes[i].computeBounds();
+        m_meshes[i].m_meshlets = buildMeshlets(m_meshes[i].m_vertices, m_meshes[i].m_indices);
+    });
+}
+
+void Model::optimizeMeshes()
+{
+    std::vector<MeshOptimizationStats> stats(m_meshes.size());
+    tbb::parallel_for(size_t(0), m_meshes.size(), [&](size_t i) {
+        stats[i] = optimizeMesh(m_meshes[i].m_vertices, m_meshes[i].m_indices, m_optimization);
+    });
+    MeshOptimizationStats total;
+    for(const auto& meshStats : stats){
+        total += meshStats;
+    }
+    m_vertexCount = static_cast<int>(total.verticesAfter);
+    std::cout << "Mesh optimization: vertices " << total.verticesBefore << " -> " << total.verticesAfter
+              << ", ACMR(FIFO " << MESH_OPT_CACHE_SIZE << ") " << total.acmrBefore() << " -> " << total.acmrAfter() << std::endl;
+}
+
+bool Model::loadMeshCache(const QString& path)
+{
+    QFileInfo source(path);
+    QFile file(path + MESH_CACHE_SUFFIX);
+    if(!source.exists() || !file.exists() || !file.open(QIODevice::ReadOnly)){
+        return false;
+    }
+    const qint64 size = file.size();
+    if(size < static_cast<qint64>(sizeof(MeshCacheHeader))){
+        return false;
+    }
+    // 整个文件映射进内存，顶点与索引直接从映射区整块拷贝，不做逐元素解析
+    const uchar* data = file.map(0, size);
+    if(!data){
+        return false;
+    }
+    const uchar* end = data + size;
+    const uchar* cursor = data;
+    auto readable = [&](size_t bytes) { return static_cast<size_t>(end - cursor) >= bytes; };
+
+    MeshCacheHeader header;
+    std::memcpy(&header, cursor, sizeof(header));
+    cursor += sizeof(header);
+    bool valid = std::memcmp(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) == 0
+                 && header.version == MESH_CACHE_VERSION
+                 && header.vertexSize == sizeof(Vertex)
+                 && header.optimization == static_cast<uint32_t>(m_optimization)
+                 && header.requestedNativeImporter == (m_requestedNativeImporter ? 1u : 0u)
+                 && header.sourceSize == source.size()
+                 && header.sourceModified == source.lastModified().toMSecsSinceEpoch();
+
+    std::vector<QString> texturePaths;
+    for(uint32_t i = 0; valid && i < header.textureCount; i++){
+        uint32_t length = 0;
+        valid = readable(sizeof(length));
+        if(valid){
+            std::memcpy(&length, cursor, sizeof(length));
+            cursor += sizeof(length);
+            valid = readable(length);
+        }
+        if(valid){
+            texturePaths.push_back(QString::fromStdString(std::string(reinterpret_cast<const char*>(cursor), length)));
+            cursor += length;
+        }
+    }
+    std::vector<MeshCacheEntry> entries(valid ? header.meshCount : 0);
+    valid = valid && readable(sizeof(MeshCacheEntry) * entries.size());
+    if(valid){
+        std::memcpy(entries.data(), cursor, sizeof(MeshCacheEntry) * entries.size());
+        cursor += sizeof(MeshCacheEntry) * entries.size();
+        size_t payload = 0;
+        for(const auto& entry : entries){
+            payload += sizeof(Vertex) * entry.vertexCount + sizeof(unsigned) * entry.indexCount;
+        }
+        valid = readable(payload);
+    }
+    if(!valid){
+        file.unmap(const_cast<uchar*>(data));
+        return false;
+    }
+
+    m_directory = path.mid(0, path.lastIndexOf('/'));
+    m_meshes.resize(entries.size());
+    for(size_t i = 0; i < entries.size(); i++){
+        Mesh& mesh = m_meshes[i];
+        mesh.m_vertices.resize(entries[i].vertexCount);
+        std::memcpy(mesh.m_vertices.data(), cursor, sizeof(Vertex) * entries[i].vertexCount);
+        cursor += sizeof(Vertex) * entries[i].vertexCount;
+        mesh.m_normalTextureIndex = entries[i].normalTexture;
+        mesh.m_diffuseTextureIndex = entries[i].diffuseTexture;
+        mesh.m_specularTextureIndex = entries[i].specularTexture;
+    }
+    for(size_t i = 0; i < entries.size(); i++){
+        Mesh& mesh = m_meshes[i];
+        mesh.m_indices.resize(entries[i].indexCount);
+        std::memcpy(mesh.m_indices.data(), cursor, sizeof(unsigned) * entries[i].indexCount);
+        cursor += sizeof(unsigned) * entries[i].indexCount;
+    }
+    file.unmap(const_cast<uchar*>(data));
+
+    m_nativeImporter = header.nativeImporter != 0;
+    m_triangleCount = header.triangleCount;
+    m_vertexCount = header.vertexCount;
+    m_minX = header.bounds[0];
+    m_minY = header.bounds[1];
+    m_minZ = header.bounds[2];
+    m_maxX = header.bounds[3];
+    m_maxY = header.bounds[4];
+    m_maxZ = header.bounds[5];
+    m_centre = Coord3D(header.centre[0], header.centre[1], header.centre[2]);
+    std::memcpy(&m_modelNormalizationMatrix[0][0], header.normalization, sizeof(header.normalization));
+
+    // 纹理仍交给纹理缓存异步解码，下标与缓存中记录的一致
+    for(const QString& texturePath : texturePaths){
+        m_pendingTextures.push_back(TextureCache::getInstance().load(m_directory + '/' + texturePath, SRendererDevice::getInstance().m_textureLayout));
+    }
+    resolveTextures();
+    return true;
+}
+
+void Model::saveMeshCache(const QString& path)
+{
+    QFileInfo source(path);
+    MeshCacheHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+    header.version = MESH_CACHE_VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.optimization = static_cast<uint32_t>(m_optimization);
+    header.requestedNativeImporter = m_requestedNativeImporter ? 1u : 0u;
+    header.nativeImporter = m_nativeImporter ? 1u : 0u;
+    header.sourceSize = source.size();
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+    header.meshCount = static_cast<uint32_t>(m_meshes.size());
+    header.textureCount = static_cast<uint32_t>(m_textureList.size());
+    header.triangleCount = m_triangleCount;
+    header.vertexCount = m_vertexCount;
+    const float bounds[6] = {m_minX, m_minY, m_minZ, m_maxX, m_maxY, m_maxZ};
+    std::memcpy(header.bounds, bounds, sizeof(bounds));
+    header.centre[0] = m_centre.x;
+    header.centre[1] = m_centre.y;
+    header.centre[2] = m_centre.z;
+    std::memcpy(header.normalization, &m_modelNormalizationMatrix[0][0], sizeof(header.normalization));
+
+    // 先写临时文件再整体替换，写到一半失败不会留下损坏的缓存；目录不可写时只是不生成缓存
+    QSaveFile file(path + MESH_CACHE_SUFFIX);
+    if(!file.open(QIODevice::WriteOnly)){
+        std::cout << "mesh cache not written: " << path.toStdString() << MESH_CACHE_SUFFIX << std::endl;
+        return;
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    for(const Texture& texture : m_textureList){
+        std::string relative = texture.m_path.mid(m_directory.size() + 1).toStdString(); // 相对模型目录保存
+        uint32_t length = static_cast<uint32_t>(relative.size());
+        file.write(reinterpret_cast<const char*>(&length), sizeof(length));
+        file.write(relative.data(), length);
+    }
+    for(const Mesh& mesh : m_meshes){
+        MeshCacheEntry entry{static_cast<uint32_t>(mesh.m_vertices.size()), static_cast<uint32_t>(mesh.m_indices.size()),
+                             mesh.m_normalTextureIndex, mesh.m_diffuseTextureIndex, mesh.m_specularTextureIndex};
+        file.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+    }
+    for(const Mesh& mesh : m_meshes){
+        file.write(reinterpret_cast<const char*>(mesh.m_vertices.data()), sizeof(Vertex) * mesh.m_vertices.size());
+    }
+    for(const Mesh& mesh : m_meshes){
+        file.write(reinterpret_cast<const char*>(mesh.m_indices.data()), sizeof(unsigned) * mesh.m_indices.size());
+    }
+    if(!file.commit()){
+        std::cout << "mesh cache not written: " << path.toStdString() << MESH_CACHE_SUFFIX << std::endl;
+    }
 }
 
 glm::mat4 Model::getModelTansformation()
@@ -2,6 +2,9 @@
 #define MODEL_H
 
 #include <iostream>
+#include <future>
+#include <string>
+#include <unordered_map>
 #include <QDir>
 #include <QDebug>
 #include <QFileInfo>
@@ -10,6 +13,9 @@
 #include "assimp/scene.h"
 #include "assimp/postprocess.h"
 #include "Mesh.h"
+#include "TextureCache.h"
+#include "ObjLoader.h"
+#include "MeshOptimizer.h"
 #include "BasicDataStructure.h"
 
 
@@ -21,7 +27,14 @@ public:
     int m_vertexCount;
     bool m_loadSuccess;
 
-    Model(QString path);
+    // useMeshCache: 优先读取模型旁的二进制缓存，没有或过期时重新导入并写出缓存
+    // nativeObj: OBJ 文件使用原生多线程解析器，失败时以及其他格式使用 Assimp
+    // optimization: 导入后对每个网格做的顶点焊接与三角形/顶点重排
+    Model(QString path, bool useMeshCache = true, bool nativeObj = true,
+          MeshOptimization optimization = MeshOptimization::OVERDRAW);
+    ~Model(); // 释放首次绘制时在设备上创建的缓冲与纹理
+    Model(const Model&) = delete;
+    Model& operator=(const Model&) = delete;
     float getYRange();
     void draw();
     glm::mat4 getModelTansformation();
@@ -34,14 +47,28 @@ private:
     float m_maxZ;
 
     std::vector<Mesh> m_meshes;
-    std::vector<Texture> m_textureList;
+    std::vector<Texture> m_textureList; // 首次绘制时移交给设备，之后为空
+    std::vector<BufferHandle> m_textureHandles; // 设备上的纹理，网格的纹理下标已改为这些句柄
+    std::unordered_map<std::string, int> m_textureIndex; // 纹理路径 -> 下标，用于去重
+    std::vector<std::shared_future<Texture>> m_pendingTextures; // 加载期间正在解码的纹理，下标与 m_textureIndex 一致
     QString m_directory;
     glm::mat4 m_modelNormalizationMatrix;
+    MeshOptimization m_optimization; // 写入网格缓存，缓存与请求的优化级别不同时重新导入
+    bool m_requestedNativeImporter; // 请求使用原生 OBJ 解析器，缓存按它匹配
+    bool m_nativeImporter; // 网格实际由原生 OBJ 解析器导入(而不是 Assimp)，写入网格缓存
 
-    void loadModel(QString path);
+    void loadModel(QString path, bool nativeObj);
+    bool loadObjModel(const QString& path);
     void processNode(aiNode *node, const aiScene *scene);
     Mesh processMesh(aiMesh *mesh, const aiScene *scene);
     int loadMaterialTextures(Mesh &mesh, aiMaterial *mat, aiTextureType type);
+    int requestTexture(const QString& path);
+    void resolveTextures();
+    void uploadTextures();
+    void optimizeMeshes();
+    void computeMeshBounds(); // 网格包围体与 meshlet 划分，不写入网格缓存
+    bool loadMeshCache(const QString& path);
+    void saveMeshCache(const QString& path);
 };
 
 #endif // MODEL_H
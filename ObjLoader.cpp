@@ -0,0 +1,439 @@
+#include "ObjLoader.h"
+#include <algorithm>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <thread>
+#include "tbb/parallel_for.h"
+
+namespace
+{
+
+constexpr size_t OBJ_MIN_CHUNK_BYTES = 1 << 20; // 每块至少 1MB，小文件不拆分
+constexpr int OBJ_MISSING = -1;                 // 面顶点缺少纹理坐标或法线
+constexpr int OBJ_INVALID = -2;                 // 下标为 0(OBJ 中无效)，换算时报错
+constexpr int OBJ_RELATIVE_BASE = -(1 << 30);   // 负下标先记为块内相对位置，块的全局偏移确定后再换算
+
+struct FaceVertex // v/vt/vn 下标，解析完成后为从 0 开始的全局下标
+{
+    int position;
+    int texCoord;
+    int normal;
+};
+
+struct MaterialRun // 从第 firstTriangle 个三角形起使用 material(块内材质名下标)
+{
+    size_t firstTriangle;
+    int material;
+};
+
+struct ObjChunk // 一块文本的解析结果
+{
+    std::vector<Coord3D> positions;
+    std::vector<Coord2D> texCoords;
+    std::vector<Vector3D> normals;
+    std::vector<FaceVertex> triangles; // 三角化后每 3 个为一个三角形
+    std::vector<MaterialRun> materialRuns;
+    std::vector<std::string> materialNames;
+    std::vector<std::string> materialLibraries;
+    size_t positionBase{0}, texCoordBase{0}, normalBase{0}; // 之前各块的元素总数
+    bool valid{true};
+};
+
+struct WeldKey
+{
+    int position, texCoord, normal;
+    bool operator==(const WeldKey& other) const
+    {
+        return position == other.position && texCoord == other.texCoord && normal == other.normal;
+    }
+};
+
+struct WeldKeyHash
+{
+    size_t operator()(const WeldKey& key) const
+    {
+        uint64_t h = static_cast<uint32_t>(key.position) * 0x9E3779B97F4A7C15ull;
+        h ^= (static_cast<uint32_t>(key.texCoord) + 0x7F4A7C15ull + (h << 6) + (h >> 2)) * 0xBF58476D1CE4E5B9ull;
+        h ^= (static_cast<uint32_t>(key.normal) + 0x94D049BBull + (h << 6) + (h >> 2)) * 0x94D049BB133111EBull;
+        return static_cast<size_t>(h ^ (h >> 31));
+    }
+};
+
+inline const char* skipSpaces(const char* p, const char* end)
+{
+    while(p < end && (*p == ' ' || *p == '\t')){
+        p++;
+    }
+    return p;
+}
+
+inline const char* parseFloat(const char* p, const char* end, float& value)
+{
+    p = skipSpaces(p, end);
+    if(p < end && *p == '+'){ // from_chars 不接受前导 '+'
+        p++;
+    }
+    auto res = std::from_chars(p, end, value);
+    return res.ec == std::errc() ? res.ptr : nullptr;
+}
+
+inline const char* parseInt(const char* p, const char* end, int& value)
+{
+    auto res = std::from_chars(p, end, value);
+    return res.ec == std::errc() ? res.ptr : nullptr;
+}
+
+// 去掉首尾空白后的剩余部分(用于 usemtl / mtllib 等带名字的语句)
+inline std::string restOfLine(const char* p, const char* end)
+{
+    p = skipSpaces(p, end);
+    while(end > p && (end[-1] == ' ' || end[-1] == '\t' || end[-1] == '\r')){
+        end--;
+    }
+    return std::string(p, end);
+}
+
+// OBJ 下标从 1 开始，负数表示相对当前已定义元素的位置
+inline int encodeIndex(int index, size_t localCount)
+{
+    if(index > 0){
+        return index - 1;
+    }
+    if(index == 0){
+        return OBJ_INVALID;
+    }
+    return OBJ_RELATIVE_BASE + static_cast<int>(localCount) + index;
+}
+
+inline bool resolveIndex(int& index, size_t base, size_t total)
+{
+    if(index == OBJ_MISSING){
+        return true;
+    }
+    if(index == OBJ_INVALID){
+        return false;
+    }
+    if(index < OBJ_MISSING){
+        index = index - OBJ_RELATIVE_BASE + static_cast<int>(base);
+    }
+    return index >= 0 && static_cast<size_t>(index) < total;
+}
+
+void parseChunk(const char* begin, const char* end, ObjChunk& chunk)
+{
+    std::vector<FaceVertex> polygon;
+    const char* line = begin;
+    while(line < end){
+        const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', end - line));
+        if(!lineEnd){
+            lineEnd = end;
+        }
+        const char* p = skipSpaces(line, lineEnd);
+        const char* next = lineEnd + 1;
+        if(p + 1 >= lineEnd){
+            line = next;
+            continue;
+        }
+
+        if(p[0] == 'v' && p[1] == ' '){
+            Coord3D pos;
+            p = parseFloat(p + 2, lineEnd, pos.x);
+            p = p ? parseFloat(p, lineEnd, pos.y) : nullptr;
+            p = p ? parseFloat(p, lineEnd, pos.z) : nullptr;
+            chunk.valid &= (p != nullptr);
+            chunk.positions.push_back(pos);
+        }
+        else if(p[0] == 'v' && p[1] == 't'){
+            Coord2D tex(0.f);
+            p = parseFloat(p + 2, lineEnd, tex.x);
+            if(p){
+                parseFloat(p, lineEnd, tex.y); // 一维纹理坐标时 v 为 0
+            }
+            chunk.valid &= (p != nullptr);
+            tex.y = 1.f - tex.y; // 与 aiProcess_FlipUVs 一致
+            chunk.texCoords.push_back(tex);
+        }
+        else if(p[0] == 'v' && p[1] == 'n'){
+            Vector3D normal;
+            p = parseFloat(p + 2, lineEnd, normal.x);
+            p = p ? parseFloat(p, lineEnd, normal.y) : nullptr;
+            p = p ? parseFloat(p, lineEnd, normal.z) : nullptr;
+            chunk.valid &= (p != nullptr);
+            chunk.normals.push_back(normal);
+        }
+        else if(p[0] == 'f' && (p[1] == ' ' || p[1] == '\t')){
+            // 每个面顶点的形式：v、v/vt、v//vn、v/vt/vn
+            polygon.clear();
+            p = skipSpaces(p + 1, lineEnd);
+            while(p && p < lineEnd && *p != '\r'){
+                FaceVertex fv{OBJ_MISSING, OBJ_MISSING, OBJ_MISSING};
+                int index = 0;
+                p = parseInt(p, lineEnd, index);
+                if(!p){
+                    break;
+                }
+                fv.position = encodeIndex(index, chunk.positions.size());
+                if(p < lineEnd && *p == '/'){
+                    p++;
+                    if(p < lineEnd && *p != '/'){
+                        p = parseInt(p, lineEnd, index);
+                        fv.texCoord = p ? encodeIndex(index, chunk.texCoords.size()) : OBJ_MISSING;
+                    }
+                    if(p && p < lineEnd && *p == '/'){
+                        p = parseInt(p + 1, lineEnd, index);
+                        fv.normal = p ? encodeIndex(index, chunk.normals.size()) : OBJ_MISSING;
+                    }
+                }
+                chunk.valid &= (p != nullptr);
+                polygon.push_back(fv);
+                p = p ? skipSpaces(p, lineEnd) : nullptr;
+            }
+            // 扇形三角化，点和线图元直接丢弃
+            for(size_t i = 2; i < polygon.size(); i++){
+                chunk.triangles.push_back(polygon[0]);
+                chunk.triangles.push_back(polygon[i - 1]);
+                chunk.triangles.push_back(polygon[i]);
+            }
+        }
+        else if(lineEnd - p > 7 && std::equal(p, p + 7, "usemtl ")){
+            chunk.materialNames.push_back(restOfLine(p + 7, lineEnd));
+            chunk.materialRuns.push_back({chunk.triangles.size() / 3, static_cast<int>(chunk.materialNames.size()) - 1});
+        }
+        else if(lineEnd - p > 7 && std::equal(p, p + 7, "mtllib ")){
+            chunk.materialLibraries.push_back(restOfLine(p + 7, lineEnd));
+        }
+        // 其余语句(注释、o、g、s 等)不影响渲染，忽略
+        line = next;
+    }
+}
+
+// MTL 贴图语句可带 -bm 1.0、-o u v w 之类的选项，跳过选项及其数值参数后剩下的部分为文件名
+QString parseTexturePath(const std::string& args)
+{
+    std::istringstream stream(args);
+    std::vector<std::string> tokens;
+    std::string token;
+    while(stream >> token){
+        tokens.push_back(token);
+    }
+    size_t i = 0;
+    while(i < tokens.size() && tokens[i].size() > 1 && tokens[i][0] == '-'){
+        i++;
+        while(i + 1 < tokens.size()){
+            float value;
+            const std::string& arg = tokens[i];
+            bool numeric = std::from_chars(arg.data(), arg.data() + arg.size(), value).ec == std::errc();
+            if(!numeric && arg != "on" && arg != "off"){
+                break;
+            }
+            i++;
+        }
+    }
+    std::string path;
+    for(; i < tokens.size(); i++){
+        path += (path.empty() ? "" : " ") + tokens[i];
+    }
+    return QString::fromStdString(path);
+}
+
+} // namespace
+
+void ObjLoader::loadMaterialLibrary(const QString& path)
+{
+    std::ifstream file(path.toStdString());
+    if(!file){
+        std::cout << "Failed to open material library: " << path.toStdString() << std::endl;
+        return;
+    }
+    ObjMaterial* current = nullptr;
+    std::string line;
+    while(std::getline(file, line)){
+        const char* begin = line.data();
+        const char* end = begin + line.size();
+        const char* p = skipSpaces(begin, end);
+        const char* keyEnd = p;
+        while(keyEnd < end && *keyEnd != ' ' && *keyEnd != '\t'){
+            keyEnd++;
+        }
+        std::string key(p, keyEnd);
+        std::string rest = restOfLine(keyEnd, end);
+        if(key == "newmtl"){
+            current = &m_materials[rest];
+        }
+        else if(!current){
+            continue;
+        }
+        else if(key == "map_Kd"){
+            current->diffuseMap = parseTexturePath(rest);
+        }
+        else if(key == "map_Ks"){
+            current->specularMap = parseTexturePath(rest);
+        }
+        else if(key == "map_Bump" || key == "map_bump" || key == "bump"){
+            current->bumpMap = parseTexturePath(rest);
+        }
+    }
+}
+
+bool ObjLoader::load(const QString& path)
+{
+    std::ifstream file(path.toStdString(), std::ios::binary | std::ios::ate);
+    if(!file){
+        return false;
+    }
+    std::string text(static_cast<size_t>(file.tellg()), '\0');
+    file.seekg(0);
+    file.read(text.data(), text.size());
+    const char* data = text.data();
+    const size_t size = text.size();
+
+    // 1. 按行边界切块并行解析，块内的负下标先记为相对位置
+    const size_t maxChunks = std::max(1u, std::thread::hardware_concurrency());
+    const size_t chunkCount = std::max<size_t>(1, std::min(maxChunks, size / OBJ_MIN_CHUNK_BYTES));
+    std::vector<size_t> bounds(chunkCount + 1, size);
+    bounds[0] = 0;
+    for(size_t i = 1; i < chunkCount; i++){
+        size_t pos = std::max(bounds[i - 1], size * i / chunkCount);
+        const void* newline = std::memchr(data + pos, '\n', size - pos);
+        bounds[i] = newline ? static_cast<const char*>(newline) - data + 1 : size;
+    }
+    std::vector<ObjChunk> chunks(chunkCount);
+    tbb::parallel_for(size_t(0), chunkCount, [&](size_t i) {
+        parseChunk(data + bounds[i], data + bounds[i + 1], chunks[i]);
+    });
+
+    // 2. 求各块的全局偏移，合并顶点属性，再并行把面下标换算为全局下标
+    std::vector<Coord3D> positions;
+    std::vector<Coord2D> texCoords;
+    std::vector<Vector3D> normals;
+    std::vector<std::string> libraries;
+    for(auto& chunk : chunks){
+        if(!chunk.valid){
+            std::cout << "OBJ parse error in " << path.toStdString() << std::endl;
+            return false;
+        }
+        chunk.positionBase = positions.size();
+        chunk.texCoordBase = texCoords.size();
+        chunk.normalBase = normals.size();
+        positions.insert(positions.end(), chunk.positions.begin(), chunk.positions.end());
+        texCoords.insert(texCoords.end(), chunk.texCoords.begin(), chunk.texCoords.end());
+        normals.insert(normals.end(), chunk.normals.begin(), chunk.normals.end());
+        libraries.insert(libraries.end(), chunk.materialLibraries.begin(), chunk.materialLibraries.end());
+    }
+    std::vector<char> chunkValid(chunkCount, 1);
+    tbb::parallel_for(size_t(0), chunkCount, [&](size_t i) {
+        ObjChunk& chunk = chunks[i];
+        for(FaceVertex& fv : chunk.triangles){
+            if(!resolveIndex(fv.position, chunk.positionBase, positions.size()) || fv.position == OBJ_MISSING
+               || !resolveIndex(fv.texCoord, chunk.texCoordBase, texCoords.size())
+               || !resolveIndex(fv.normal, chunk.normalBase, normals.size())){
+                chunkValid[i] = 0;
+                return;
+            }
+        }
+    });
+    if(std::find(chunkValid.begin(), chunkValid.end(), 0) != chunkValid.end()){
+        std::cout << "OBJ face index out of range in " << path.toStdString() << std::endl;
+        return false;
+    }
+
+    // 3. 把各块的三角形按材质分组(usemtl 的作用范围跨越块边界)
+    struct TriangleRange
+    {
+        const FaceVertex* begin;
+        size_t count; // 三角形数
+    };
+    std::vector<std::string> materialOrder;
+    std::unordered_map<std::string, size_t> materialSlot;
+    std::vector<std::vector<TriangleRange>> groups;
+    auto slotOf = [&](const std::string& name) {
+        auto it = materialSlot.find(name);
+        if(it != materialSlot.end()){
+            return it->second;
+        }
+        materialSlot.emplace(name, materialOrder.size());
+        materialOrder.push_back(name);
+        groups.emplace_back();
+        return materialOrder.size() - 1;
+    };
+    std::string currentMaterial;
+    for(const auto& chunk : chunks){
+        const size_t triangleCount = chunk.triangles.size() / 3;
+        size_t start = 0;
+        for(size_t r = 0; r <= chunk.materialRuns.size(); r++){
+            size_t stop = r < chunk.materialRuns.size() ? chunk.materialRuns[r].firstTriangle : triangleCount;
+            if(stop > start){
+                groups[slotOf(currentMaterial)].push_back({chunk.triangles.data() + 3 * start, stop - start});
+            }
+            if(r < chunk.materialRuns.size()){
+                currentMaterial = chunk.materialNames[chunk.materialRuns[r].material];
+                start = stop;
+            }
+        }
+    }
+
+    // 4. 每个材质一个网格，并行焊接顶点；没有法线的顶点用同一位置上各面法线的平均值(平滑法线)
+    m_meshes.assign(groups.size(), {});
+    tbb::parallel_for(size_t(0), groups.size(), [&](size_t g) {
+        ObjMesh& mesh = m_meshes[g];
+        mesh.material = materialOrder[g];
+        std::unordered_map<WeldKey, unsigned, WeldKeyHash> welded;
+        std::unordered_map<int, Vector3D> smoothNormals; // 位置下标 -> 法线累加
+        std::vector<int> vertexPositions; // 每个焊接后顶点的位置下标，用于回填平滑法线
+        bool missingNormals = false;
+        for(const TriangleRange& range : groups[g]){
+            for(size_t t = 0; t < range.count; t++){
+                const FaceVertex* tri = range.begin + 3 * t;
+                bool triangleMissingNormal = false;
+                for(int k = 0; k < 3; k++){
+                    const FaceVertex& fv = tri[k];
+                    triangleMissingNormal |= (fv.normal == OBJ_MISSING);
+                    auto [it, inserted] = welded.try_emplace(WeldKey{fv.position, fv.texCoord, fv.normal},
+                                                             static_cast<unsigned>(mesh.vertices.size()));
+                    if(inserted){
+                        Vertex vertex{};
+                        vertex.worldSpacePos = positions[fv.position];
+                        vertex.texCoord = fv.texCoord != OBJ_MISSING ? texCoords[fv.texCoord] : Coord2D(0.f);
+                        vertex.normal = fv.normal != OBJ_MISSING ? normals[fv.normal] : Vector3D(0.f);
+                        mesh.vertices.push_back(vertex);
+                        vertexPositions.push_back(fv.normal != OBJ_MISSING ? -1 : fv.position);
+                    }
+                    mesh.indices.push_back(it->second);
+                }
+                if(triangleMissingNormal){
+                    missingNormals = true;
+                    const Coord3D& p0 = positions[tri[0].position];
+                    Vector3D faceNormal = glm::cross(positions[tri[1].position] - p0, positions[tri[2].position] - p0);
+                    float length = glm::length(faceNormal);
+                    if(length > 0.f){ // 退化三角形不参与平均
+                        for(int k = 0; k < 3; k++){
+                            smoothNormals[tri[k].position] += faceNormal / length;
+                        }
+                    }
+                }
+            }
+        }
+        if(missingNormals){
+            for(size_t v = 0; v < mesh.vertices.size(); v++){
+                if(vertexPositions[v] < 0){
+                    continue;
+                }
+                Vector3D sum = smoothNormals[vertexPositions[v]];
+                float length = glm::length(sum);
+                mesh.vertices[v].normal = length > 0.f ? sum / length : Vector3D(0.f, 1.f, 0.f);
+            }
+        }
+    });
+    m_meshes.erase(std::remove_if(m_meshes.begin(), m_meshes.end(), [](const ObjMesh& mesh) { return mesh.indices.empty(); }),
+                   m_meshes.end());
+
+    // 5. 材质库路径相对 OBJ 所在目录
+    const QString directory = path.mid(0, path.lastIndexOf('/'));
+    for(const std::string& library : libraries){
+        loadMaterialLibrary(directory + '/' + QString::fromStdString(library));
+    }
+    return !m_meshes.empty();
+}
@@ -0,0 +1,38 @@
+#ifndef OBJLOADER_H
+#define OBJLOADER_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <QString>
+#include "BasicDataStructure.h"
+
+// 原生 Wavefront OBJ/MTL 加载器：文件按行切成若干块并行解析(std::from_chars)，
+// 再按材质分组，用哈希表焊接相同的 位置/纹理坐标/法线 组合。
+// 结果与 Assimp 以 Triangulate | GenSmoothNormals | FlipUVs 导入时一致：多边形扇形三角化、缺失法线时生成平滑法线、v 坐标翻转
+struct ObjMesh
+{
+    std::vector<Vertex> vertices;
+    std::vector<unsigned> indices;
+    std::string material; // usemtl 指定的材质名，未指定时为空
+};
+
+struct ObjMaterial // 只保留渲染用到的贴图，路径为 MTL 中的原始写法
+{
+    QString diffuseMap;  // map_Kd
+    QString specularMap; // map_Ks
+    QString bumpMap;     // map_Bump / bump，对应 Assimp 的 aiTextureType_HEIGHT
+};
+
+class ObjLoader
+{
+public:
+    std::vector<ObjMesh> m_meshes; // 每个材质一个网格，按材质首次出现的顺序
+    std::unordered_map<std::string, ObjMaterial> m_materials;
+
+    bool load(const QString& path); // 文件无法读取或格式错误(如下标越界)时返回 false，由调用者回退到 Assimp
+private:
+    void loadMaterialLibrary(const QString& path);
+};
+
+#endif // OBJLOADER_H
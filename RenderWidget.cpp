@@ -1,15 +1,12 @@
 #include "RenderWidget.h"
 #include "ui_RenderWidget.h"
 #include "Mat.h"
+#include <chrono>
 
 const int FPS_UPDATE_INTERVAL_MS = 500;
 
 int lastFrameTime = 0;
 int deltaTime = 0;
-QPoint lastPos;
-QPoint currentPos;
-int ratio = 0;
-Qt::MouseButtons currentBtns;
 
 QElapsedTimer fpsUpdateElapsedTimer;
 int frameCount = 0; // 用于统计帧数
@@ -17,83 +14,128 @@ float accumulatedDeltaTime = 0.0f; // 累积的帧间时间
 
 RenderWidget::RenderWidget(QWidget *parent)
     : QWidget(parent)
-    , ui(new Ui::RenderWidget)
-    ,m_camera(static_cast<float>(DEFAULT_WIDTH) / static_cast<float>(DEFAULT_HEIGHT), FIXED_CAMERA_FAR)
     ,m_width(DEFAULT_WIDTH)
     ,m_height(DEFAULT_HEIGHT)
     ,m_isPaused(true)
+    ,ui(new Ui::RenderWidget)
+    ,m_modelLoaded(false)
+    ,m_camera(static_cast<float>(DEFAULT_WIDTH) / static_cast<float>(DEFAULT_HEIGHT), FIXED_CAMERA_FAR)
     ,m_model(nullptr)
+    ,m_stopRendering(false)
+    ,m_completedFrames(0)
+    ,m_presentedFrames(0)
+    ,m_frameTimeUs(0)
+    ,m_mouseButtons(Qt::NoButton)
+    ,m_pendingRotation(0.f)
+    ,m_pendingZoom(0)
 {
     ui->setupUi(this);
     ui->FPSLabel->setStyleSheet("background:transparent");
     setFixedSize(m_width, m_height);
     initDevice();
-    connect(&m_timer, &QTimer::timeout, this, &RenderWidget::render);
+    m_renderThread = std::thread(&RenderWidget::renderLoop, this);
+    connect(&m_timer, &QTimer::timeout, this, &RenderWidget::presentFrame);
     m_timer.start(1);
 }
 
 RenderWidget::~RenderWidget()
 {
+    m_timer.stop();
+    m_stopRendering = true;
+    m_renderThread.join();
     delete ui;
 }
 
-void RenderWidget::setLightColor(Color color, LightColorType type)
+void RenderWidget::postCommand(RenderCommand command)
 {
-    switch(type)
-    {
-    case LightColorType::DIFFUSE:
-        SRendererDevice::getInstance().m_shader->m_lightList[0].diffuse = color;
-        break;
-    case LightColorType::SPECULAR:
-        SRendererDevice::getInstance().m_shader->m_lightList[0].specular = color;
-        break;
-    case LightColorType::AMBIENT:
-        SRendererDevice::getInstance().m_shader->m_lightList[0].ambient = color;
-        break;
+    while(!m_commands.push(std::move(command))){ // 渲染线程每帧开始前清空队列，满时只需等当前帧结束
+        std::this_thread::yield();
     }
 }
 
+void RenderWidget::setLightColor(Color color, LightColorType type)
+{
+    postCommand([color, type](){
+        switch(type)
+        {
+        case LightColorType::DIFFUSE:
+            SRendererDevice::getInstance().m_shader->m_lightList[0].diffuse = color;
+            break;
+        case LightColorType::SPECULAR:
+            SRendererDevice::getInstance().m_shader->m_lightList[0].specular = color;
+            break;
+        case LightColorType::AMBIENT:
+            SRendererDevice::getInstance().m_shader->m_lightList[0].ambient = color;
+            break;
+        }
+    });
+}
+
 void RenderWidget::setLightDir(Vector4D dir)
 {
-    SRendererDevice::getInstance().m_shader->m_lightList[0].dir = dir;
+    postCommand([dir](){ SRendererDevice::getInstance().m_shader->m_lightList[0].dir = dir; });
 }
 
 void RenderWidget::setRenderMode(RendererMode mode)
 {
-    SRendererDevice::getInstance().m_rendererMode = mode;
+    postCommand([mode](){ SRendererDevice::getInstance().m_rendererMode = mode; });
 }
 
 void RenderWidget::setFaceCulling(bool val)
 {
-    SRendererDevice::getInstance().m_faceCulling = val;
+    postCommand([val](){ SRendererDevice::getInstance().m_faceCulling = val; });
 }
 
 void RenderWidget::setMultiThread(bool val)
 {
-    SRendererDevice::getInstance().m_multiThread = val;
+    postCommand([val](){ SRendererDevice::getInstance().m_multiThread = val; });
 }
 
-<<<<<<< HEAD
-=======
 void RenderWidget::setTBBMultiThread(bool val)
 {
-    SRendererDevice::getInstance().m_tbbThread = val;
+    postCommand([val](){ SRendererDevice::getInstance().m_tbbThread = val; });
+}
+
+void RenderWidget::setSIMD(bool val)
+{
+    postCommand([val](){ SRendererDevice::getInstance().m_simd = val; });
+}
+
+void RenderWidget::setTileBinning(bool val)
+{
+    postCommand([val](){ SRendererDevice::getInstance().m_tileBinning = val; });
 }
 
->>>>>>> future
- void RenderWidget::setSIMD(bool val)
+void RenderWidget::setVisibilityBuffer(bool val)
 {
-    SRendererDevice::getInstance().m_simd = val;
+    postCommand([val](){ SRendererDevice::getInstance().m_visibilityBuffer = val; });
+}
+
+void RenderWidget::setTextureFilter(TextureFilter filter)
+{
+    postCommand([filter](){ SRendererDevice::getInstance().m_textureFilter = filter; });
 }
 
-<<<<<<< HEAD
-=======
 void RenderWidget::setFXAA(bool val)
 {
-    SRendererDevice::getInstance().m_useFXAA = val;
+    postCommand([val](){ SRendererDevice::getInstance().m_useFXAA = val; });
+}
+
+void RenderWidget::setShaderTexture(bool val)
+{
+    postCommand([val](){ SHADERTEXTURE = val; }); // 着色器在每个片元读取该标志，只能在两帧之间修改
+}
+
+void RenderWidget::setCameraFov(float fov)
+{
+    postCommand([this, fov](){ m_camera.m_fov = fov; });
+}
+
+void RenderWidget::setCameraNear(float zNear)
+{
+    postCommand([this, zNear](){ m_camera.m_zNear = zNear; });
 }
 
->>>>>>> future
 void RenderWidget::showFPS(qint64 &elapsed)
 {
     // int nowTime = QTime::currentTime().msecsSinceStartOfDay();
@@ -123,10 +165,7 @@ void RenderWidget::showFPS(qint64 &elapsed)
 
 void RenderWidget::saveImage(QString path)
 {
-<<<<<<< HEAD
-=======
      std::cout << "it is  RenderWidget::saveImage" << std::endl;
->>>>>>> future
     SRendererDevice::getInstance().saveImage(path);
 }
 
@@ -139,18 +178,25 @@ void RenderWidget::loadmodel(QString path)
         return;
     }
 
-    if(m_model){
-        // 若model指针不为空，即原来已经加载了模型
+    if(m_modelLoaded){
+        // 原来已经加载了模型
         // 更新渲染控制状态
         togglePause();
     }
-
-    // 将新模型的数据存入维护的内存中
-    m_model = std::move(newModel);
+    m_modelLoaded = true;
 
     // 更新模型数据
-    sendModelData(m_model->m_triangleCount, m_model->m_vertexCount);
-    resetCamera();
+    sendModelData(newModel->m_triangleCount, newModel->m_vertexCount);
+    ui->FPSLabel->setVisible(true);
+
+    // 模型交给渲染线程，在两帧之间替换旧模型并重置相机(旧模型在渲染线程上释放)
+    const Coord3D centre = newModel->m_centre;
+    const float yRange = newModel->getYRange();
+    std::shared_ptr<Model> model = std::move(newModel);
+    postCommand([this, model, centre, yRange](){
+        m_model = model;
+        m_camera.setCamera(centre, yRange);
+    });
     std::cout << "model load success" ;
 }
 
@@ -159,34 +205,39 @@ void RenderWidget::initDevice() // ////////////////////
     SRendererDevice::init(m_width, m_height);
     SRendererDevice::getInstance().m_shader = std::make_unique<BlinnPhongShader>();
     SRendererDevice::getInstance().m_shader->m_lightList.push_back(Light());
+    SRendererDevice::getInstance().getFrameBuffer().setColorBufferCount(3); // 渲染线程写一个，GUI 显示一个，另一个保存最近完成的帧
 }
 
 void RenderWidget::togglePause()
 {
-    m_isPaused = !m_isPaused;
+    m_isPaused = !m_isPaused.load();
 }
 
 void RenderWidget::paintEvent(QPaintEvent *event)
 {
     QPainter painter(this);
-    painter.drawImage(0, 0, SRendererDevice::getInstance().getInstance().getBuffer());
+    painter.drawImage(0, 0, SRendererDevice::getInstance().getPresentImage());
 }
 
 void RenderWidget::mousePressEvent(QMouseEvent *event)
 {
-    currentBtns = event->buttons();
-    currentPos = event->pos();
-    lastPos = {0, 0};
+    m_mouseButtons = event->buttons();
+    m_lastMousePos = event->pos();
 }
 
 void RenderWidget::mouseReleaseEvent(QMouseEvent *event)
 {
-    currentBtns = event->buttons();
+    m_mouseButtons = event->buttons();
 }
 
 void RenderWidget::mouseMoveEvent(QMouseEvent *event)
 {
-    currentPos = event->pos();
+    if((m_mouseButtons & Qt::LeftButton) || (m_mouseButtons & Qt::RightButton)){
+        QPoint motion = event->pos() - m_lastMousePos;
+        m_pendingRotation.x += static_cast<float>(motion.x()) / m_width;
+        m_pendingRotation.y += static_cast<float>(motion.y()) / m_height;
+    }
+    m_lastMousePos = event->pos();
 }
 
 void RenderWidget::wheelEvent(QWheelEvent *event)
@@ -202,80 +253,71 @@ void RenderWidget::wheelEvent(QWheelEvent *event)
         QPoint numSteps = numDegrees / 15;
         res = numSteps;
     }
-    ratio += res.y();
+    m_pendingZoom += res.y();
 }
 
 
-void RenderWidget::render()
+void RenderWidget::presentFrame()
 {
-    if(m_isPaused){
-        return;
+    if(m_pendingRotation != Vector2D(0.f) || m_pendingZoom != 0){
+        postCommand([this, rotation = m_pendingRotation, zoom = m_pendingZoom](){
+            if(rotation != Vector2D(0.f)){
+                m_camera.rotateAroundTarget(rotation);
+            }
+            if(zoom != 0){
+                m_camera.cloaseToTarget(zoom);
+            }
+        });
+        m_pendingRotation = Vector2D(0.f);
+        m_pendingZoom = 0;
     }
 
-    auto& renderDevice = SRendererDevice::getInstance();
-
-    renderDevice.clearBuffer(); // 清屏
-    if(this->m_model == nullptr){return;}
-
-    int nowTime = QTime::currentTime().msecsSinceStartOfDay();
-    if(lastFrameTime != 0){
-        deltaTime = nowTime - lastFrameTime;
-        ui->FPSLabel->setText(QString("FPS : %1").arg(1000.0 / deltaTime, 0, 'f', 0));
+    const unsigned completedFrames = m_completedFrames.load(std::memory_order_acquire);
+    if(completedFrames == m_presentedFrames){
+        return;
+    }
+    m_presentedFrames = completedFrames;
+    const int frameTimeUs = m_frameTimeUs.load(std::memory_order_relaxed);
+    if(frameTimeUs > 0){
+        ui->FPSLabel->setText(QString("FPS : %1").arg(1000000.0 / frameTimeUs, 0, 'f', 0));
     }
-    lastFrameTime = nowTime;
+    update();
+}
 
-    // qint64 elapsed = fpsUpdateElapsedTimer.elapsed();
-    // fpsUpdateElapsedTimer.restart(); // 重启计时器以测量下一帧时间
-    // deltaTime = elapsed / 1000.0f; // 将毫秒转换为秒
-    // accumulatedDeltaTime += deltaTime;
-    // frameCount++;
+void RenderWidget::renderLoop()
+{
+    RenderCommand command;
+    auto lastFrameEnd = std::chrono::steady_clock::now();
+    while(!m_stopRendering.load()){
+        while(m_commands.pop(command)){ // 两帧之间执行 GUI 线程提交的全部命令
+            command();
+        }
+        if(m_isPaused.load() || m_model == nullptr){
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            lastFrameEnd = std::chrono::steady_clock::now();
+            continue;
+        }
+        renderFrame();
 
-    // if (fpsUpdateElapsedTimer.hasExpired(FPS_UPDATE_INTERVAL_MS)) {
+        auto now = std::chrono::steady_clock::now();
+        m_frameTimeUs.store(static_cast<int>(std::chrono::duration_cast<std::chrono::microseconds>(now - lastFrameEnd).count()), std::memory_order_relaxed);
+        lastFrameEnd = now;
+        m_completedFrames.fetch_add(1, std::memory_order_release);
+    }
+}
 
-    //     float avgDeltaTime = accumulatedDeltaTime / frameCount;
-    //     float currentFPS = (avgDeltaTime > 0) ? (1.0f / avgDeltaTime) : 0.0f;
-    //     ui->FPSLabel->setText(QString("FPS : %1").arg(currentFPS, 0, 'f', 0));
-    //     // 重置计数器和累积时间
-    //     frameCount = 0;
-    //     accumulatedDeltaTime = 0.0f;
-    // }
+void RenderWidget::renderFrame()
+{
+    auto& renderDevice = SRendererDevice::getInstance();
 
-    processInput();
+    renderDevice.clearBuffer(); // 清屏
     renderDevice.m_shader->m_modelTransformation = m_model->getModelTansformation();
     renderDevice.m_shader->m_viewTransformation = m_camera.getViewMatrix();
     renderDevice.m_shader->m_projectionTransformation = m_camera.getProjectionMatrix();
     renderDevice.m_shader->m_eyePos = m_camera.m_position;
     renderDevice.m_shader->m_material.shininess = SHININESS;
 
-    this->m_model->draw();
-    update();
-}
-
-void RenderWidget::processInput()
-{
-    if((currentBtns & Qt::LeftButton) || (currentBtns & Qt::RightButton)){
-        if(!lastPos.isNull()){
-            Vector2D motion = {static_cast<float>((currentPos - lastPos).x()), static_cast<float>((currentPos - lastPos).y())};
-            motion.x = (motion.x / m_width);
-            motion.y = (motion.y) / m_height;
-            if(currentBtns & Qt::LeftButton){
-                m_camera.rotateAroundTarget(motion);
-            }
-            if(currentBtns & Qt::RightButton){
-                m_camera.rotateAroundTarget(motion);
-            }
-        }
-        lastPos = currentPos;
-    }
-    if(ratio != 0){
-        m_camera.cloaseToTarget(ratio);
-        ratio = 0;
-    }
-}
-
-void RenderWidget::resetCamera()
-{
-    ui->FPSLabel->setVisible(true);
-    m_camera.setCamera(m_model->m_centre, m_model->getYRange());
-    //m_camera.setCamera(Vector3D(0.f, 0.f, -1.f), m_model->getYRange());
+    m_model->draw();
+    renderDevice.resolveFrame();
+    renderDevice.presentFrame(); // 交给 GUI 线程显示，下一帧写入另一个颜色缓冲
 }
@@ -3,6 +3,9 @@
 
 #include <iostream>
 #include <memory>
+#include <atomic>
+#include <thread>
+#include <functional>
 #include <QTime>
 #include <QTimer>
 #include <QElapsedTimer>
@@ -15,6 +18,7 @@
 #include "Model.h"
 #include "BlinnPhongShader.h"
 #include "SRendererDevice.h"
+#include "SPSCQueue.h"
 #include "BasicDataStructure.h"
 
 
@@ -22,18 +26,19 @@ const int DEFAULT_WIDTH = 800;
 const int DEFAULT_HEIGHT = 600;
 const float FIXED_CAMERA_FAR = 100.f;
 static constexpr float SHININESS = 150.f;
+static constexpr size_t RENDER_COMMAND_CAPACITY = 256; // GUI 线程发往渲染线程的命令队列容量
 
 namespace Ui {
 class RenderWidget;
 }
 
+// 渲染在独立的渲染线程中进行：帧缓冲为三缓冲，GUI 线程只显示最近完成的一帧。
+// 设置、输入与相机更新都包装成命令经无锁队列交给渲染线程，在两帧之间执行，渲染线程独占相机、模型与设备状态
 class RenderWidget : public QWidget
 {
     Q_OBJECT
 
 public:
-    Camera m_camera;
-
     explicit RenderWidget(QWidget *parent = nullptr);
     ~RenderWidget();
     void setLightColor(Color color, LightColorType type);
@@ -41,13 +46,15 @@ public:
     void setRenderMode(RendererMode mode);
     void setFaceCulling(bool val);
     void setMultiThread(bool val);
-<<<<<<< HEAD
-    void setSIMD(bool val);
-=======
     void setTBBMultiThread(bool val);
     void setSIMD(bool val);
+    void setTileBinning(bool val);
+    void setVisibilityBuffer(bool val);
+    void setTextureFilter(TextureFilter filter);
     void setFXAA(bool val);
->>>>>>> future
+    void setShaderTexture(bool val);
+    void setCameraFov(float fov);
+    void setCameraNear(float zNear);
     void saveImage(QString path);
     void loadmodel(QString path);
     void initDevice();
@@ -64,19 +71,39 @@ protected:
 signals:
     void sendModelData(int triangleCount, int vertexCount);
 public slots:
-    void render();
+    void presentFrame(); // GUI 线程定时调用：提交累积的鼠标输入，有新完成的帧时重绘
 private:
+    using RenderCommand = std::function<void()>;
+
     int m_width;
     int m_height;
-    bool m_isPaused;
+    std::atomic<bool> m_isPaused;
     QTimer m_timer;
     QElapsedTimer m_elapsedTimer;
     std::thread m_fpsShowThread;
     Ui::RenderWidget *ui;
-    std::unique_ptr<Model> m_model;
+    bool m_modelLoaded; // GUI 线程记录是否已加载过模型
+
+    // 以下只由渲染线程访问
+    Camera m_camera;
+    std::shared_ptr<Model> m_model;
+
+    std::thread m_renderThread;
+    std::atomic<bool> m_stopRendering;
+    SPSCQueue<RenderCommand, RENDER_COMMAND_CAPACITY> m_commands; // GUI 线程生产，渲染线程消费
+    std::atomic<unsigned> m_completedFrames; // 渲染线程每完成一帧加一
+    unsigned m_presentedFrames; // GUI 线程已显示到的帧序号
+    std::atomic<int> m_frameTimeUs; // 最近一帧的帧间隔(微秒)，用于显示 FPS
+
+    // 鼠标输入在 GUI 线程累积，每次 presentFrame() 合并成一条命令
+    Qt::MouseButtons m_mouseButtons;
+    QPoint m_lastMousePos;
+    Vector2D m_pendingRotation;
+    int m_pendingZoom;
 
-    void processInput();
-    void resetCamera();
+    void postCommand(RenderCommand command); // 队列满时等待渲染线程取走命令
+    void renderLoop();
+    void renderFrame();
 };
 
 #endif // RENDERWIGET_H
@@ -3,14 +3,11 @@
 #include "ui_Widget.h"
 
 bool SHADERTEXTURE = false;
-<<<<<<< HEAD
-=======
 bool AMBIENT = false;
 bool DIFFUSE = false;
 bool SPECULAR = false;
 
 bool FXAA = false;
->>>>>>> future
 
 Widget::Widget(QWidget *parent)
     : QMainWindow(parent)
@@ -29,11 +26,7 @@ Widget::~Widget()
 void Widget::setOption(Option option, bool val)
 {
     if(option == Option::MUTITHREAD){
-<<<<<<< HEAD
-        ui->actionMultithread->setChecked(val);
-=======
         ui->actionMultiThread->setChecked(val);
->>>>>>> future
         ui->renderWidget->setMultiThread(val);
     }
     else if(option == Option::FACECULLING){
@@ -44,6 +37,18 @@ void Widget::setOption(Option option, bool val)
         ui->actionSIMD->setChecked(val);
         ui->renderWidget->setSIMD(val);
     }
+    else if(option == Option::TILEBINNING){
+        ui->actionTileBinning->setChecked(val);
+        ui->renderWidget->setTileBinning(val);
+    }
+    else if(option == Option::VISIBILITYBUFFER){
+        ui->actionVisibilityBuffer->setChecked(val);
+        ui->renderWidget->setVisibilityBuffer(val);
+    }
+    else if(option == Option::MIPMAP){
+        ui->actionMipmap->setChecked(val);
+        ui->renderWidget->setTextureFilter(val ? TextureFilter::TRILINEAR : TextureFilter::NEAREST);
+    }
     else{
         return;
     }
@@ -53,11 +58,11 @@ void Widget::setCameraPara(CameraPara para, float val)
 {
     if(para == CameraPara::FOV){
         ui->Fovlabel_val->setText(QString::number(static_cast<int>(val)));
-        ui->renderWidget->m_camera.m_fov = val;
+        ui->renderWidget->setCameraFov(val);
     }
     else if(para == CameraPara::NEAR){
         ui->Nearlabel_val->setText(QString::number((static_cast<int>(val))));
-        ui->renderWidget->m_camera.m_zNear = val;
+        ui->renderWidget->setCameraNear(val);
     }
     else{
         return;
@@ -103,6 +108,9 @@ void Widget::initUi()
     setOption(Option::MUTITHREAD, true);
     setOption(Option::FACECULLING, true);
     setOption(Option::SIMD, true);
+    setOption(Option::TILEBINNING, true);
+    setOption(Option::VISIBILITYBUFFER, false);
+    setOption(Option::MIPMAP, true);
     setCameraPara(CameraPara::FOV, 60.f);
     setCameraPara(CameraPara::NEAR, 1.f);
     setLightColor(LightColorType::SPECULAR, QColor(255, 255, 255));
@@ -129,10 +137,7 @@ void Widget::on_actionopen_file_triggered()
     if(!modelFilelPath.isEmpty()){
         std::cout << " loading model" << std::endl;
         ui->renderWidget->loadmodel(modelFilelPath);
-<<<<<<< HEAD
-=======
         ui->MeshcheckBox->setChecked(true);
->>>>>>> future
     }
 
     else{
@@ -143,13 +148,6 @@ void Widget::on_actionopen_file_triggered()
 
 void Widget::on_actionsave_image_triggered()
 {
-<<<<<<< HEAD
-    QString fileName = QFileDialog::getSaveFileName(this, "save Image", "", "PNG(*.png)");
-    if(!fileName.isEmpty()){
-        ui->renderWidget->saveImage(fileName);
-    }
-    else{
-=======
     // ui->renderWidget->togglePause();
 
     QString filter = "All Files (*);;JPG(*.jpg);;PNG(*.png)";
@@ -176,7 +174,6 @@ void Widget::on_actionsave_image_triggered()
     }
     else{
         // ui->renderWidget->togglePause();
->>>>>>> future
         return;
     }
 }
@@ -233,17 +230,11 @@ void Widget::on_Yawdial_valueChanged(int value)
     setLightDir();
 }
 
-<<<<<<< HEAD
-void Widget::on_actionMultithread_triggered()
-{
-    if(ui->actionMultithread->isChecked()){
-=======
 void Widget::on_actionMultiThread_triggered()
 {
     ui->actionTbbMultiThread->setChecked(false);
     if(ui->actionMultiThread->isChecked()){
         ui->renderWidget->setTBBMultiThread(false);
->>>>>>> future
         ui->renderWidget->setMultiThread(true);
     }
     else{
@@ -251,8 +242,6 @@ void Widget::on_actionMultiThread_triggered()
     }
 }
 
-<<<<<<< HEAD
-=======
 void Widget::on_actionTbbMultiThread_triggered()
 {
     ui->actionMultiThread->setChecked(false);
@@ -265,7 +254,6 @@ void Widget::on_actionTbbMultiThread_triggered()
     }
 }
 
->>>>>>> future
 void Widget::on_actionFaceCulling_triggered()
 {
     if(ui->actionFaceCulling->isChecked()){
@@ -286,22 +274,46 @@ void Widget::on_actionSIMD_triggered()
     }
 }
 
-<<<<<<< HEAD
+void Widget::on_actionTileBinning_triggered()
+{
+    if(ui->actionTileBinning->isChecked()){
+        ui->renderWidget->setTileBinning(true);
+    }
+    else{
+        ui->renderWidget->setTileBinning(false);
+    }
+}
+
+void Widget::on_actionVisibilityBuffer_triggered()
+{
+    if(ui->actionVisibilityBuffer->isChecked()){
+        ui->renderWidget->setVisibilityBuffer(true);
+    }
+    else{
+        ui->renderWidget->setVisibilityBuffer(false);
+    }
+}
+
+void Widget::on_actionMipmap_triggered()
+{
+    if(ui->actionMipmap->isChecked()){
+        ui->renderWidget->setTextureFilter(TextureFilter::TRILINEAR);
+    }
+    else{
+        ui->renderWidget->setTextureFilter(TextureFilter::NEAREST);
+    }
+}
 
-=======
->>>>>>> future
 void Widget::on_actionTexture_triggered()
 {
     if(ui->actionTexture->isChecked()){
-        SHADERTEXTURE = true;
+        ui->renderWidget->setShaderTexture(true);
     }
     else{
-        SHADERTEXTURE = false;
+        ui->renderWidget->setShaderTexture(false);
     }
 }
 
-<<<<<<< HEAD
-=======
 
 
 void Widget::on_checkBox_checkStateChanged(const Qt::CheckState &arg1)
@@ -314,4 +326,3 @@ void Widget::on_checkBox_checkStateChanged(const Qt::CheckState &arg1)
 }
 
 
->>>>>>> future
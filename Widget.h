@@ -1,11 +1,7 @@
 #ifndef WIDGET_H
 #define WIDGET_H
 
-<<<<<<< HEAD
-
-=======
 #include <QFileInfo>
->>>>>>> future
 #include <QFileDialog>
 #include <QMainWindow>
 #include "RenderWidget.h"
@@ -18,7 +14,10 @@ enum class Option
 {
     MUTITHREAD,
     FACECULLING,
-    SIMD
+    SIMD,
+    TILEBINNING,
+    VISIBILITYBUFFER,
+    MIPMAP
 };
 
 namespace Ui {
@@ -55,13 +54,9 @@ private slots:
 
     void on_VertexCheckBox_checkStateChanged(const Qt::CheckState &arg1);
 
-<<<<<<< HEAD
-    void on_actionMultithread_triggered();
-=======
     void on_actionMultiThread_triggered();
 
     void on_actionTbbMultiThread_triggered();
->>>>>>> future
 
     void on_actionFaceCulling_triggered();
 
@@ -69,13 +64,16 @@ private slots:
 
     void on_actionSIMD_triggered();
 
+    void on_actionTileBinning_triggered();
+
+    void on_actionVisibilityBuffer_triggered();
+
+    void on_actionMipmap_triggered();
+
     void on_actionTexture_triggered();
 
-<<<<<<< HEAD
-=======
     void on_checkBox_checkStateChanged(const Qt::CheckState &arg1);
 
->>>>>>> future
 private:
     Ui::Widget *ui;
     QColor m_specularColor;
@@ -2,6 +2,7 @@
 #define BASICDATASTRUCTURE_H
 
 #include <array>
+#include <vector>
 #include <immintrin.h>
 #include "glm/glm.hpp"
 
@@ -43,6 +44,19 @@ enum class LightColorType //光着色属性(漫反射，高光，环境光)
     AMBIENT
 };
 
+enum class TextureFilter //纹理过滤方式
+{
+    NEAREST,   // 最近点，只用原始层级
+    BILINEAR,  // 在最接近的 mip 层级上双线性
+    TRILINEAR  // 相邻两个 mip 层级的双线性结果再线性插值
+};
+
+enum class TextureLayout //纹素在内存中的排列方式
+{
+    LINEAR, // 行主序
+    TILED   // 4x4 纹素为一块(64 字节，恰好一条缓存行)，块内行主序，块按行排列
+};
+
 struct Vertex //顶点
 {
     Coord3D worldSpacePos;
@@ -68,6 +82,8 @@ struct Fragment //片
     Color fragmentColor;
     Vector3D normal;
     Coord2D texCoord;
+    Vector2D texCoordDx; // 纹理坐标对屏幕 x 的偏导，用于选择 mip 层级
+    Vector2D texCoordDy; // 纹理坐标对屏幕 y 的偏导
 };
 
 struct Light //光着色
@@ -96,20 +112,22 @@ struct SimdVectorI3D
     __m256i x, y, z;
 };
 
-<<<<<<< HEAD
-=======
 struct SimdVector2D
 {
     __m256 x,y;
 };
 
->>>>>>> future
 // 用于存储8个浮点向量 (例如，8个Vector3D) 的结构体
 struct SimdVector3D
 {
     __m256 x, y, z;
 };
 
+struct SimdVector4D
+{
+    __m256 x, y, z, w;
+};
+
 struct SimdColor // 用于存储8个浮点颜色向量 (R, G, B)
 {
     __m256 r, g, b;
@@ -120,26 +138,64 @@ struct SimdFragment
     __m256i screenPosX, screenPosY;
     __m256  screenDepth;
     __m256  viewDepth; // 存储插值后的 1/w (用于透视校正)
-<<<<<<< HEAD
-    SimdVector3D texCoord; // 存储插值后的 TexCoord/w
-=======
-    SimdVector2D texCoord; // 存储插值后的 TexCoord/w
->>>>>>> future
-    SimdVector3D normal;   // 存储插值后的 Normal/w
-    SimdVector3D worldSpacePos; // 存储插值后的 WorldSpacePos/w
+    SimdVector2D texCoord; // 存储插值后的 TexCoord/w，经 correctPerspectiveSimd 后为 TexCoord
+    SimdVector2D texCoordDx, texCoordDy; // 纹理坐标对屏幕 x、y 的偏导，用于选择 mip 层级
+    SimdVector3D normal;   // 存储插值后的 Normal/w，经 correctPerspectiveSimd 后为 Normal
+    SimdVector3D worldSpacePos; // 存储插值后的 WorldSpacePos/w，经 correctPerspectiveSimd 后为 WorldSpacePos
     SimdColor fragmentColor; // 由 SIMD 片元着色器计算
     // 构造函数或辅助函数用于填充
 };
 
-<<<<<<< HEAD
+struct SimdVertex // 8个顶点，供 SIMD 顶点着色
+{
+    SimdVector3D worldSpacePos;
+    SimdVector4D clipSpacePos;
+    SimdVector3D normal;
+    SimdVector2D texCoord;
+};
 
+struct VertexStream // SoA 形式的顶点输入流，只保存不可变的输入属性；长度按8填充，SIMD 读取尾部时不会越界
+{
+    std::vector<float> posX, posY, posZ;
+    std::vector<float> normalX, normalY, normalZ;
+    std::vector<float> texU, texV;
+    size_t count{0}; // 实际顶点数(不含填充)
+
+    void assign(const std::vector<Vertex>& vertices)
+    {
+        count = vertices.size();
+        size_t padded = (count + 7) & ~size_t(7);
+        for(auto* stream : {&posX, &posY, &posZ, &normalX, &normalY, &normalZ, &texU, &texV}){
+            stream->assign(padded, 0.f);
+        }
+        for(size_t i = 0; i < count; i++){
+            const Vertex& v = vertices[i];
+            posX[i] = v.worldSpacePos.x;
+            posY[i] = v.worldSpacePos.y;
+            posZ[i] = v.worldSpacePos.z;
+            normalX[i] = v.normal.x;
+            normalY[i] = v.normal.y;
+            normalZ[i] = v.normal.z;
+            texU[i] = v.texCoord.x;
+            texV[i] = v.texCoord.y;
+        }
+    }
+};
+
+struct Meshlet // 网格索引中一段连续的三角形，加载时划分，绘制前整体做视锥与背面(法线锥)剔除
+{
+    unsigned triangleOffset; // 在网格索引中的第一个三角形
+    unsigned triangleCount;
+    Coord3D centre; // 模型空间包围球
+    float radius;
+    Vector3D coneAxis; // 三角形法线的平均方向
+    float coneCutoff;  // 法线与轴最大夹角的正弦，>= 1 时法线锥过宽，不做背面剔除
+};
 
-=======
 struct SimdMaterial {
     __m256 shininess;
     __m256i diffTextureIdx;
     __m256i specTextureIdx;
 };
->>>>>>> future
 
 #endif // BASICDATASTRUCTURE_H
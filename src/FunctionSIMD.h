@@ -6,74 +6,6 @@
 #include <immintrin.h>
 #include "BasicDataStructure.h"
 
-<<<<<<< HEAD
-
-inline __m256 simd_dot_ps(const SimdVector3D& a, const SimdVector3D& b)
-{
-    __m256 x_mul = _mm256_mul_ps(a.x, b.x);
-    __m256 y_mul = _mm256_mul_ps(a.y, b.y);
-    __m256 z_mul = _mm256_mul_ps(a.z, b.z);
-    return _mm256_add_ps(_mm256_add_ps(x_mul, y_mul), z_mul);
-}
-
-// SIMD Vector Length Squared for SimdVector3D
-inline __m256 simd_length_squared_ps(const SimdVector3D& v)
-{
-    return simd_dot_ps(v, v);
-}
-
-// SIMD Vector Length for SimdVector3D
-inline __m256 simd_length_ps(const SimdVector3D& v)
-{
-    return _mm256_sqrt_ps(simd_length_squared_ps(v));
-}
-
-// SIMD Vector Normalization for SimdVector3D
-inline SimdVector3D simd_normalize_ps(const SimdVector3D& v)
-{
-    __m256 length = simd_length_ps(v);
-    // Handle division by zero or very small lengths (optional but good practice)
-    __m256 epsilon = _mm256_set1_ps(1e-6f);
-    length = _mm256_max_ps(length, epsilon); // Ensure length is not zero or too small
-    __m256 one_over_length = _mm256_div_ps(_mm256_set1_ps(1.0f), length); // 1 / length
-    SimdVector3D normalized_v;
-    normalized_v.x = _mm256_mul_ps(v.x, one_over_length);
-    normalized_v.y = _mm256_mul_ps(v.y, one_over_length);
-    normalized_v.z = _mm256_mul_ps(v.z, one_over_length);
-    return normalized_v;
-}
-
-// Placeholder SIMD log_ps (Natural Logarithm)
-inline __m256 simd_log_ps(__m256 x)
-{
-    // ** Placeholder Implementation: Replace with actual SIMD log **
-    // Using a simple approximation for demonstration.
-    // For proper implementation, search for "SIMD log polynomial approximation" or use VML.
-    // Example using a Taylor series around 1 (very limited range of accuracy):
-    __m256 x_minus_1 = _mm256_sub_ps(x, _mm256_set1_ps(1.0f));
-    __m256 x_minus_1_sq = _mm256_mul_ps(x_minus_1, x_minus_1);
-    __m256 x_minus_1_cub = _mm256_mul_ps(x_minus_1_sq, x_minus_1);
-    __m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.0f), x_minus_1), // x-1
-                                  _mm256_mul_ps(_mm256_set1_ps(-0.5f), x_minus_1_sq)); // -0.5 * (x-1)^2
-    result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_set1_ps(1.0f/3.0f), x_minus_1_cub)); // + 1/3 * (x-1)^3
-    // Basic handling for input <= 0 (log is undefined)
-    __m256 le_zero_mask = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LE_OS);
-    result = _mm256_blendv_ps(result, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()), le_zero_mask);
-    return result;
-}
-// Placeholder SIMD exp_ps (e to the power of x)
-inline __m256 simd_exp_ps(__m256 x)
-{
-    // ** Placeholder Implementation: Replace with actual SIMD exp **
-    // Using a simple Taylor series around 0 for demonstration.
-    // For proper implementation, search for "SIMD exp polynomial approximation" or use VML.
-    // Example using Taylor series (very limited range of accuracy):
-    __m256 one_ps = _mm256_set1_ps(1.0f);
-    __m256 x_sq = _mm256_mul_ps(x, x);
-    __m256 x_cub = _mm256_mul_ps(x_sq, x);
-    __m256 x_pow_4 = _mm256_mul_ps(x_cub, x);
-    __m256 result = _mm256_add_ps(one_ps, x); // 1 + x
-=======
 // 点乘
 static inline __m256 simd_dot_ps(const SimdVector3D& vec1, const SimdVector3D& vec2)
 {
@@ -106,49 +38,55 @@ static inline SimdVector3D simd_normalize_ps(const SimdVector3D& vec)
     return normalizedVec;
 }
 
-// Placeholder SIMD log_ps (Natural Logarithm)
-static inline __m256 simd_log_ps(__m256 val)
-{
-    __m256 xMinus1 = _mm256_sub_ps(val, _mm256_set1_ps(1.0f));
-    __m256 xMinusSq = _mm256_mul_ps(xMinus1, xMinus1);
-    __m256 xMinusCub = _mm256_mul_ps(xMinusSq, xMinus1);
-    __m256 result = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(1.0f), xMinus1), // x-1
-                                  _mm256_mul_ps(_mm256_set1_ps(-0.5f), xMinusSq)); // -0.5 * (x-1)^2
-    result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_set1_ps(1.0f/3.0f), xMinusCub)); // + 1/3 * (x-1)^3
-    // Basic handling for input <= 0 (log is undefined)
-    __m256 leZeroMask = _mm256_cmp_ps(val, _mm256_setzero_ps(), _CMP_LE_OS);
-    result = _mm256_blendv_ps(result, _mm256_set1_ps(std::numeric_limits<float>::quiet_NaN()), leZeroMask);
-    return result;
-}
-
-// Placeholder SIMD exp_ps (e to the power of x)
-static inline __m256 simd_exp_ps(__m256 val)
-{
-    __m256 onePs = _mm256_set1_ps(1.0f);
-    __m256 x_sq = _mm256_mul_ps(val, val);
-    __m256 x_cub = _mm256_mul_ps(x_sq, val);
-    __m256 x_pow_4 = _mm256_mul_ps(x_cub, val);
-    __m256 result = _mm256_add_ps(onePs, val); // 1 + x
->>>>>>> future
-    result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_set1_ps(0.5f), x_sq)); // + x^2 / 2!
-    result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_set1_ps(1.0f/6.0f), x_cub)); // + x^3 / 3!
-    result = _mm256_add_ps(result, _mm256_mul_ps(_mm256_set1_ps(1.0f/24.0f), x_pow_4)); // + x^4 / 4!
-    // Proper implementation requires range reduction and handling large/small results.
-    return result;
-}
-
+// 以2为底的对数：x = m * 2^e，m 取在 [sqrt(0.5), sqrt(2))，log2(m) 用 atanh 级数展开(x 须为正规化正数)
+static inline __m256 simd_log2_ps(__m256 val)
+{
+    __m256i bits = _mm256_castps_si256(val);
+    __m256i exponent = _mm256_sub_epi32(_mm256_srli_epi32(bits, 23), _mm256_set1_epi32(127));
+    __m256 mantissa = _mm256_castsi256_ps(_mm256_or_si256(_mm256_and_si256(bits, _mm256_set1_epi32(0x007FFFFF)),
+                                                          _mm256_set1_epi32(0x3F800000))); // [1, 2)
+    __m256 bigMask = _mm256_cmp_ps(mantissa, _mm256_set1_ps(1.41421356f), _CMP_GT_OQ);
+    mantissa = _mm256_blendv_ps(mantissa, _mm256_mul_ps(mantissa, _mm256_set1_ps(0.5f)), bigMask);
+    __m256 e = _mm256_add_ps(_mm256_cvtepi32_ps(exponent), _mm256_and_ps(bigMask, _mm256_set1_ps(1.f)));
+
+    // log2(m) = 2 / ln2 * (t + t^3 / 3 + t^5 / 5 + t^7 / 7 + t^9 / 9)，t = (m - 1) / (m + 1)
+    __m256 one = _mm256_set1_ps(1.f);
+    __m256 t = _mm256_div_ps(_mm256_sub_ps(mantissa, one), _mm256_add_ps(mantissa, one));
+    __m256 t2 = _mm256_mul_ps(t, t);
+    __m256 poly = _mm256_fmadd_ps(t2, _mm256_set1_ps(1.f / 9.f), _mm256_set1_ps(1.f / 7.f));
+    poly = _mm256_fmadd_ps(poly, t2, _mm256_set1_ps(1.f / 5.f));
+    poly = _mm256_fmadd_ps(poly, t2, _mm256_set1_ps(1.f / 3.f));
+    poly = _mm256_fmadd_ps(poly, t2, one);
+    __m256 logM = _mm256_mul_ps(_mm256_mul_ps(poly, t), _mm256_set1_ps(2.88539008f)); // 2 / ln2
+    return _mm256_add_ps(e, logM);
+}
+
+// 2 的幂：x = n + f，n 取最近整数，f 位于 [-0.5, 0.5]，2^f 用泰勒展开，2^n 直接写入指数位
+// 结果低于 2^-125 时直接返回 0，避免产生非规格化数拖慢后续运算
+static inline __m256 simd_exp2_ps(__m256 val)
+{
+    __m256 underflowMask = _mm256_cmp_ps(val, _mm256_set1_ps(-125.f), _CMP_GE_OQ);
+    val = _mm256_min_ps(_mm256_max_ps(val, _mm256_set1_ps(-125.f)), _mm256_set1_ps(126.f));
+    __m256 n = _mm256_round_ps(val, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+    __m256 f = _mm256_sub_ps(val, n);
+    // 系数为 ln2^k / k!
+    __m256 poly = _mm256_fmadd_ps(f, _mm256_set1_ps(1.5403530e-4f), _mm256_set1_ps(1.3333558e-3f));
+    poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(9.6181291e-3f));
+    poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(5.5504109e-2f));
+    poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(0.24022651f));
+    poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(0.69314718f));
+    poly = _mm256_fmadd_ps(poly, f, _mm256_set1_ps(1.f));
+    __m256i scale = _mm256_slli_epi32(_mm256_add_epi32(_mm256_cvtps_epi32(n), _mm256_set1_epi32(127)), 23);
+    return _mm256_and_ps(_mm256_mul_ps(poly, _mm256_castsi256_ps(scale)), underflowMask);
+}
+
+// base^exponent = 2^(exponent * log2(base))，base <= 0 时返回 0(用于高光项，底数已被限制为非负)
 inline __m256 simd_pow_ps(__m256 base, __m256 exponent)
 {
-    __m256 log_base = simd_log_ps(base);
-    __m256 y_times_log_x = _mm256_mul_ps(exponent, log_base);
-<<<<<<< HEAD
-    // Calculate exp(y * log(x)). exp of NaN is NaN.
-    __m256 result = simd_exp_ps(y_times_log_x);
-
-=======
-    __m256 result = simd_exp_ps(y_times_log_x);
->>>>>>> future
-    return result;
+    __m256 positiveMask = _mm256_cmp_ps(base, _mm256_set1_ps(1e-30f), _CMP_GT_OQ);
+    __m256 safeBase = _mm256_blendv_ps(_mm256_set1_ps(1.f), base, positiveMask);
+    __m256 result = simd_exp2_ps(_mm256_mul_ps(exponent, simd_log2_ps(safeBase)));
+    return _mm256_and_ps(result, positiveMask);
 }
 
 // SIMD Max function for two __m256
@@ -173,8 +111,6 @@ inline SimdVector3D simd_sub_ps(const SimdVector3D& a, const SimdVector3D& b)
     return result;
 }
 
-<<<<<<< HEAD
-=======
 
 inline SimdColor simd_mul_ps(const SimdColor& a, const SimdColor& b)
 {
@@ -185,7 +121,6 @@ inline SimdColor simd_mul_ps(const SimdColor& a, const SimdColor& b)
     return result;
 }
 
->>>>>>> future
 // SIMD Vector Multiplication (element-wise) for SimdVector3D
 inline SimdVector3D simd_mul_ps(const SimdVector3D& a, const SimdVector3D& b)
 {
@@ -207,9 +142,6 @@ inline SimdVector3D simd_add_ps(const SimdVector3D& a, const SimdVector3D& b)
     return result;
 }
 
-<<<<<<< HEAD
-// SIMD Scalar Multiplication for SimdVector3D
-=======
 inline SimdColor simd_add_ps(const SimdColor& a, const SimdColor& b)
 {
     SimdColor result;
@@ -229,7 +161,6 @@ inline SimdColor simd_scalar_mul_ps(const SimdColor& v, __m256 scalar)
     return result;
 }
 
->>>>>>> future
 inline SimdVector3D simd_scalar_mul_ps(const SimdVector3D& v, __m256 scalar)
 {
     SimdVector3D result;
@@ -240,9 +171,6 @@ inline SimdVector3D simd_scalar_mul_ps(const SimdVector3D& v, __m256 scalar)
 }
 
 
-<<<<<<< HEAD
-=======
 
 
->>>>>>> future
 #endif // FUNCTIONSIMD_H
@@ -31,6 +31,19 @@ static inline bool judgeInsideTriangle(const EdgeEquation& triEdge, const Vector
     return flag && ((res.x >= 0 && res.y >= 0 && res.z >= 0) || (res.x <= 0 && res.y <= 0 && res.z <= 0));
 }
 
+// 由像素坐标重新求三角形的屏幕空间重心坐标，与 EdgeEquation::getBarycentric 使用相同的整数边缘函数
+static inline Vector3D getScreenBarycentric(const Triangle& tri, int x, int y)
+{
+    const CoordI2D& p0 = tri[0].screenPos;
+    const CoordI2D& p1 = tri[1].screenPos;
+    const CoordI2D& p2 = tri[2].screenPos;
+    int e0 = (p0.y - p1.y) * x + (p1.x - p0.x) * y + (p0.x * p1.y - p0.y * p1.x);
+    int e1 = (p1.y - p2.y) * x + (p2.x - p1.x) * y + (p1.x * p2.y - p1.y * p2.x);
+    int e2 = (p2.y - p0.y) * x + (p0.x - p2.x) * y + (p2.x * p0.y - p2.y * p0.x);
+    float delta = 1.f / (p0.x * p1.y - p0.y * p1.x + p1.x * p2.y - p1.y * p2.x + p2.x * p0.y - p2.y * p0.x);
+    return {e1 * delta, e2 * delta, e0 * delta};
+}
+
 // 正确的视角
 template <class T>
 static inline T correctPerspective(float viewDepth, const std::vector<T>& attribute, const Triangle &tri, const Vector3D &barycentric)
@@ -96,7 +109,7 @@ static inline std::bitset<N> getClipCode(T point, const std::array<T,N>& clip)
 }
 
 // 剪裁重新构建三角形
-std::vector<Triangle> constructTriangle(const std::vector<Vertex>& vertexList)
+static inline std::vector<Triangle> constructTriangle(const std::vector<Vertex>& vertexList)
 {
     std::vector<Triangle> res;
     for(int i = 0; i< vertexList.size() -2; i++)
@@ -111,7 +124,7 @@ std::vector<Triangle> constructTriangle(const std::vector<Vertex>& vertexList)
 }
 
 // 构造片段
-Fragment constructFragment(int x, int y, float z, float viewDepth, const Triangle& tri, const Vector3D& barycentric)
+static inline Fragment constructFragment(int x, int y, float z, float viewDepth, const Triangle& tri, const Vector3D& barycentric)
 {
     Fragment frag;
     frag.screenPos.x = x;
@@ -135,17 +148,6 @@ Fragment constructFragment(int x, int y, float z, float viewDepth, const Triangl
     return frag;
 }
 
-<<<<<<< HEAD
-//SIMD
-SimdVector3D broadcastVector3D(const Vector3D& vec)
-{
-    SimdVector3D res;
-    res.x = _mm256_set1_ps(vec.x);
-    res.y = _mm256_set1_ps(vec.y);
-    res.z = _mm256_set1_ps(vec.z);
-    return res;
-}
-=======
 // //SIMD
 // SimdVector3D broadcastVector3D(const Vector3D& vec)
 // {
@@ -155,16 +157,11 @@ SimdVector3D broadcastVector3D(const Vector3D& vec)
 //     res.z = _mm256_set1_ps(vec.z);
 //     return res;
 // }
->>>>>>> future
 
 // SIMD 版本的浮点属性插值
 // bartcenTri_simd: 包含8个像素重心坐标 (alpha, beta, gamma) 的 SimdVector3D
 // 返回: 包含8个插值后浮点属性值的 __m256 向量
-<<<<<<< HEAD
-__m256 calculateInterpolationSimdFloat(float v0, float v1, float v2, const SimdVector3D& bartcenTri_simd)
-=======
 static inline __m256 calculateInterpolationSimdFloat(float v0, float v1, float v2, const SimdVector3D& bartcenTri_simd)
->>>>>>> future
 {
     // 插值公式: result = alpha * v0 + beta * v1 + gamma * v2
     // 将顶点属性值复制到8个浮点数的SIMD向量中
@@ -180,8 +177,6 @@ static inline __m256 calculateInterpolationSimdFloat(float v0, float v1, float v
 }
 
 
-<<<<<<< HEAD
-=======
 static inline SimdVector2D calculateInterpolationSimdVector2D(const glm::vec2& v0, const glm::vec2& v1, const glm::vec2& v2, const SimdVector3D& bartcenTri_simd)
 {
     // 插值公式: result = alpha * v0 + beta * v1 + gamma * v2
@@ -208,16 +203,11 @@ static inline SimdVector2D calculateInterpolationSimdVector2D(const glm::vec2& v
 }
 
 
->>>>>>> future
 // SIMD 版本的 Vector3D 属性插值
 // v0, v1, v2: 三角形三个顶点的 Vector3D 属性值
 // bartcenTri_simd: 包含8个像素重心坐标 (alpha, beta, gamma) 的 SimdVector3D
 // 返回: 包含8个插值后 Vector3D 属性值的 SimdVector3D 结构体
-<<<<<<< HEAD
-SimdVector3D calculateInterpolationSimdVector3D(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const SimdVector3D& bartcenTri_simd)
-=======
 static inline SimdVector3D calculateInterpolationSimdVector3D(const glm::vec3& v0, const glm::vec3& v1, const glm::vec3& v2, const SimdVector3D& bartcenTri_simd)
->>>>>>> future
 {
     // 插值公式: result = alpha * v0 + beta * v1 + gamma * v2
     // 这里的 v0, v1, v2 是 Vector3D，意味着需要对每个分量 (x, y, z) 分别进行插值
@@ -249,17 +239,11 @@ static inline SimdVector3D calculateInterpolationSimdVector3D(const glm::vec3& v
     return result_simd;
 }
 
-<<<<<<< HEAD
-SimdFragment constructFragmentSimd(const __m256i& x_simd, const __m256i& y_simd,
-                                   const __m256& screenDepth_simd,
-                                   const SimdVector3D& barycentric_simd,
-=======
 
 
 static inline SimdFragment constructFragmentSimd(const __m256i& x_simd, const __m256i& y_simd,
                                    const __m256& screenDepth_simd,
                                    const SimdVector3D& simdBarycentric,
->>>>>>> future
                                    const Triangle& tri)
 {
     SimdFragment frag_simd;
@@ -271,15 +255,6 @@ static inline SimdFragment constructFragmentSimd(const __m256i& x_simd, const __
     float w0_recip = 1.f / tri[0].ndcSpacePos.w; // 使用 ndcSpacePos.w，与您原始代码一致
     float w1_recip = 1.f / tri[1].ndcSpacePos.w;
     float w2_recip = 1.f / tri[2].ndcSpacePos.w;
-<<<<<<< HEAD
-    frag_simd.viewDepth = calculateInterpolationSimdFloat(w0_recip, w1_recip, w2_recip, barycentric_simd); // !!! IMPORTANT: Storing interpolated 1/w here
-    // 插值属性除以 w (用于透视校正的分子)
-    // 纹理坐标 / w 插值
-    glm::vec3 texCoord0_div_w = glm::vec3(tri[0].texCoord.x / tri[0].ndcSpacePos.w, tri[0].texCoord.y / tri[0].ndcSpacePos.w, 0.0f); // Assuming Coord2D is vec2 like
-    glm::vec3 texCoord1_div_w = glm::vec3(tri[1].texCoord.x / tri[1].ndcSpacePos.w, tri[1].texCoord.y / tri[1].ndcSpacePos.w, 0.0f);
-    glm::vec3 texCoord2_div_w = glm::vec3(tri[2].texCoord.x / tri[2].ndcSpacePos.w, tri[2].texCoord.y / tri[2].ndcSpacePos.w, 0.0f);
-    frag_simd.texCoord = calculateInterpolationSimdVector3D(texCoord0_div_w, texCoord1_div_w, texCoord2_div_w, barycentric_simd);
-=======
     frag_simd.viewDepth = calculateInterpolationSimdFloat(w0_recip, w1_recip, w2_recip, simdBarycentric); // !!! IMPORTANT: Storing interpolated 1/w here
     // 插值属性除以 w (用于透视校正的分子)
     // 纹理坐标 / w 插值
@@ -287,27 +262,87 @@ static inline SimdFragment constructFragmentSimd(const __m256i& x_simd, const __
     glm::vec2 texCoord1_div_w = glm::vec2(tri[1].texCoord.x / tri[1].ndcSpacePos.w, tri[1].texCoord.y / tri[1].ndcSpacePos.w);
     glm::vec2 texCoord2_div_w = glm::vec2(tri[2].texCoord.x / tri[2].ndcSpacePos.w, tri[2].texCoord.y / tri[2].ndcSpacePos.w);
     frag_simd.texCoord = calculateInterpolationSimdVector2D(texCoord0_div_w, texCoord1_div_w, texCoord2_div_w, simdBarycentric);
->>>>>>> future
     // 法线 / w 插值
     glm::vec3 normal0_div_w = tri[0].normal / tri[0].ndcSpacePos.w;
     glm::vec3 normal1_div_w = tri[1].normal / tri[1].ndcSpacePos.w;
     glm::vec3 normal2_div_w = tri[2].normal / tri[2].ndcSpacePos.w;
-<<<<<<< HEAD
-    frag_simd.normal = calculateInterpolationSimdVector3D(normal0_div_w, normal1_div_w, normal2_div_w, barycentric_simd);
-=======
     frag_simd.normal = calculateInterpolationSimdVector3D(normal0_div_w, normal1_div_w, normal2_div_w, simdBarycentric);
->>>>>>> future
     // 世界空间位置 / w 插值
     glm::vec3 worldSpacePos0_div_w = tri[0].worldSpacePos / tri[0].ndcSpacePos.w;
     glm::vec3 worldSpacePos1_div_w = tri[1].worldSpacePos / tri[1].ndcSpacePos.w;
     glm::vec3 worldSpacePos2_div_w = tri[2].worldSpacePos / tri[2].ndcSpacePos.w;
-<<<<<<< HEAD
-    frag_simd.worldSpacePos = calculateInterpolationSimdVector3D(worldSpacePos0_div_w, worldSpacePos1_div_w, worldSpacePos2_div_w, barycentric_simd);
-=======
     frag_simd.worldSpacePos = calculateInterpolationSimdVector3D(worldSpacePos0_div_w, worldSpacePos1_div_w, worldSpacePos2_div_w, simdBarycentric);
->>>>>>> future
 
     return frag_simd;
 }
 
+// 透视校正：Attribute = 插值(Attribute/w) / 插值(1/w)
+static inline void correctPerspectiveSimd(SimdFragment& frag_simd)
+{
+    __m256 w = _mm256_div_ps(_mm256_set1_ps(1.f), frag_simd.viewDepth);
+    frag_simd.texCoord.x = _mm256_mul_ps(frag_simd.texCoord.x, w);
+    frag_simd.texCoord.y = _mm256_mul_ps(frag_simd.texCoord.y, w);
+    frag_simd.normal.x = _mm256_mul_ps(frag_simd.normal.x, w);
+    frag_simd.normal.y = _mm256_mul_ps(frag_simd.normal.y, w);
+    frag_simd.normal.z = _mm256_mul_ps(frag_simd.normal.z, w);
+    frag_simd.worldSpacePos.x = _mm256_mul_ps(frag_simd.worldSpacePos.x, w);
+    frag_simd.worldSpacePos.y = _mm256_mul_ps(frag_simd.worldSpacePos.y, w);
+    frag_simd.worldSpacePos.z = _mm256_mul_ps(frag_simd.worldSpacePos.z, w);
+}
+
+// u/w、v/w、1/w 在屏幕空间中是线性的，它们对屏幕 x、y 的偏导在整个三角形上为常数
+struct TexCoordGradient
+{
+    float uDx, uDy; // d(u/w)/dx, d(u/w)/dy
+    float vDx, vDy; // d(v/w)/dx, d(v/w)/dy
+    float wDx, wDy; // d(1/w)/dx, d(1/w)/dy
+};
+
+// 由重心坐标的偏导(即各边缘函数的系数)求纹理坐标梯度，每个三角形只需计算一次
+static inline TexCoordGradient getTexCoordGradient(const Triangle& tri)
+{
+    const CoordI2D& p0 = tri[0].screenPos;
+    const CoordI2D& p1 = tri[1].screenPos;
+    const CoordI2D& p2 = tri[2].screenPos;
+    float delta = 1.f / (p0.x * p1.y - p0.y * p1.x + p1.x * p2.y - p1.y * p2.x + p2.x * p0.y - p2.y * p0.x);
+    // 与 getScreenBarycentric 相同的顺序：b0 = e1 * delta，b1 = e2 * delta，b2 = e0 * delta
+    const float b0Dx = (p1.y - p2.y) * delta, b0Dy = (p2.x - p1.x) * delta;
+    const float b1Dx = (p2.y - p0.y) * delta, b1Dy = (p0.x - p2.x) * delta;
+    const float b2Dx = (p0.y - p1.y) * delta, b2Dy = (p1.x - p0.x) * delta;
+    const float q0 = 1.f / tri[0].clipSpacePos.w;
+    const float q1 = 1.f / tri[1].clipSpacePos.w;
+    const float q2 = 1.f / tri[2].clipSpacePos.w;
+    const Coord2D t0 = tri[0].texCoord * q0;
+    const Coord2D t1 = tri[1].texCoord * q1;
+    const Coord2D t2 = tri[2].texCoord * q2;
+
+    TexCoordGradient grad;
+    grad.uDx = b0Dx * t0.x + b1Dx * t1.x + b2Dx * t2.x;
+    grad.uDy = b0Dy * t0.x + b1Dy * t1.x + b2Dy * t2.x;
+    grad.vDx = b0Dx * t0.y + b1Dx * t1.y + b2Dx * t2.y;
+    grad.vDy = b0Dy * t0.y + b1Dy * t1.y + b2Dy * t2.y;
+    grad.wDx = b0Dx * q0 + b1Dx * q1 + b2Dx * q2;
+    grad.wDy = b0Dy * q0 + b1Dy * q1 + b2Dy * q2;
+    return grad;
+}
+
+// 商的求导：du/dx = (d(u/w)/dx - u * d(1/w)/dx) * w，viewDepth 为插值后的 w
+static inline void setTexCoordDerivatives(Fragment& frag, const TexCoordGradient& grad, float viewDepth)
+{
+    frag.texCoordDx = Vector2D(grad.uDx - frag.texCoord.x * grad.wDx, grad.vDx - frag.texCoord.y * grad.wDx) * viewDepth;
+    frag.texCoordDy = Vector2D(grad.uDy - frag.texCoord.x * grad.wDy, grad.vDy - frag.texCoord.y * grad.wDy) * viewDepth;
+}
+
+// SIMD 版本，须在 correctPerspectiveSimd 之后调用(此时 texCoord 已校正，viewDepth 仍为插值后的 1/w)
+static inline void setTexCoordDerivativesSimd(SimdFragment& frag_simd, const TexCoordGradient& grad)
+{
+    __m256 w = _mm256_div_ps(_mm256_set1_ps(1.f), frag_simd.viewDepth);
+    __m256 wDx = _mm256_set1_ps(grad.wDx);
+    __m256 wDy = _mm256_set1_ps(grad.wDy);
+    frag_simd.texCoordDx.x = _mm256_mul_ps(_mm256_fnmadd_ps(frag_simd.texCoord.x, wDx, _mm256_set1_ps(grad.uDx)), w);
+    frag_simd.texCoordDx.y = _mm256_mul_ps(_mm256_fnmadd_ps(frag_simd.texCoord.y, wDx, _mm256_set1_ps(grad.vDx)), w);
+    frag_simd.texCoordDy.x = _mm256_mul_ps(_mm256_fnmadd_ps(frag_simd.texCoord.x, wDy, _mm256_set1_ps(grad.uDy)), w);
+    frag_simd.texCoordDy.y = _mm256_mul_ps(_mm256_fnmadd_ps(frag_simd.texCoord.y, wDy, _mm256_set1_ps(grad.vDy)), w);
+}
+
 #endif // HELPERFUNCTION_H
@@ -0,0 +1,55 @@
+#ifndef SPSCQUEUE_H
+#define SPSCQUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+// 单生产者单消费者的无锁环形队列：生产者只写 m_tail，消费者只写 m_head，两者各占一条缓存行。
+// 各自缓存对方下标的最近值，只有看起来满(或空)时才重新读取对方的原子变量。
+// 满时 push 返回 false，由生产者决定丢弃还是稍后重试
+template<typename T, size_t Capacity>
+class SPSCQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0, "capacity must be a power of two");
+
+public:
+    bool push(T&& value) // 只能由生产者线程调用
+    {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        if(tail - m_headCache == Capacity){
+            m_headCache = m_head.load(std::memory_order_acquire);
+            if(tail - m_headCache == Capacity){
+                return false;
+            }
+        }
+        m_slots[tail & (Capacity - 1)] = std::move(value);
+        m_tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& value) // 只能由消费者线程调用
+    {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if(head == m_tailCache){
+            m_tailCache = m_tail.load(std::memory_order_acquire);
+            if(head == m_tailCache){
+                return false;
+            }
+        }
+        T& slot = m_slots[head & (Capacity - 1)];
+        value = std::move(slot);
+        slot = T(); // 立即释放元素持有的资源，而不是等到该位置被再次写入
+        m_head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+private:
+    alignas(64) std::atomic<size_t> m_tail{0};
+    size_t m_headCache{0}; // 生产者私有
+    alignas(64) std::atomic<size_t> m_head{0};
+    size_t m_tailCache{0}; // 消费者私有
+    alignas(64) T m_slots[Capacity];
+};
+
+#endif // SPSCQUEUE_H
@@ -1,13 +1,64 @@
 #include "SRFrameBuffer.h"
+#include <cassert>
 
 SRFrameBuffer::SRFrameBuffer(int wide, int height)
     :m_wide(wide)
     ,m_height(height)
     ,m_depthBuffer(wide * height)
-    ,m_colorBuffer(m_wide, m_height, QImage::Format_BGR888)
+    ,m_hiZWide((wide + HIZ_BLOCK_SIZE - 1) / HIZ_BLOCK_SIZE)
+    ,m_hiZHeight((height + HIZ_BLOCK_SIZE - 1) / HIZ_BLOCK_SIZE)
+    ,m_hiZBuffer(m_hiZWide * m_hiZHeight, 1.f)
+    ,m_colorStride((wide + 7) & ~7)
+    ,m_backIndex(0)
+    ,m_frontIndex(0)
+    ,m_readyIndex(0)
 {
-    m_colorBuffer.fill(QColor(0.f, 0.f, 0.f)); // 默认颜色缓冲为黑色
-    std::fill(m_depthBuffer.begin(), m_depthBuffer.end(), 1.f); // 深度缓冲默认填充为1
+    m_colorTargets.push_back(createColorTarget());
+    m_colorData = m_colorTargets[0].data.get();
+    clearBuffer(Color(0.f)); // 默认颜色缓冲为黑色，深度缓冲填充为1
+}
+
+SRFrameBuffer::ColorTarget SRFrameBuffer::createColorTarget() const
+{
+    ColorTarget target;
+    target.data.reset(static_cast<uint32_t*>(_mm_malloc(sizeof(uint32_t) * m_colorStride * m_height, 32)));
+    target.image = QImage(reinterpret_cast<uchar*>(target.data.get()), m_wide, m_height, m_colorStride * sizeof(uint32_t), QImage::Format_RGB32);
+    return target;
+}
+
+void SRFrameBuffer::setColorBufferCount(int count)
+{
+    assert(count == 1 || count == 3);
+    m_colorTargets.resize(1);
+    while(static_cast<int>(m_colorTargets.size()) < count){
+        m_colorTargets.push_back(createColorTarget());
+        // 第一帧完成前显示端看到的是与当前缓冲相同的底色
+        std::fill_n(m_colorTargets.back().data.get(), static_cast<size_t>(m_colorStride) * m_height, m_colorTargets[0].data[0]);
+    }
+    m_backIndex = 0;
+    m_readyIndex.store(count == 3 ? 1 : 0);
+    m_frontIndex = count == 3 ? 2 : 0;
+    m_colorData = m_colorTargets[m_backIndex].data.get();
+}
+
+void SRFrameBuffer::presentColorBuffer()
+{
+    if(m_colorTargets.size() == 1){
+        return;
+    }
+    // release 保证显示端取走该下标时能看到这一帧的全部像素；换回的缓冲已不再被显示端使用
+    const int previous = m_readyIndex.exchange(m_backIndex | PRESENT_FRESH, std::memory_order_acq_rel);
+    m_backIndex = previous & ~PRESENT_FRESH;
+    m_colorData = m_colorTargets[m_backIndex].data.get();
+}
+
+QImage& SRFrameBuffer::acquirePresentImage()
+{
+    if(m_colorTargets.size() > 1 && (m_readyIndex.load(std::memory_order_relaxed) & PRESENT_FRESH)){
+        const int previous = m_readyIndex.exchange(m_frontIndex, std::memory_order_acq_rel);
+        m_frontIndex = previous & ~PRESENT_FRESH;
+    }
+    return m_colorTargets[m_frontIndex].image;
 }
 
 bool SRFrameBuffer::judgeDepth(int x, int y, float z)//深度判定
@@ -22,24 +73,26 @@ bool SRFrameBuffer::judgeDepth(int x, int y, float z)//深度判定
 
 void SRFrameBuffer::setPixel(int x, int y, const Color& color) //着色像素点
 {
-    m_colorBuffer.setPixelColor(x,
-                                m_height - 1 - y,
-                                QColor(color.r * 255.f, color.g * 255.f, color.b * 255.f));
+    m_colorData[(m_height - 1 - y) * m_colorStride + x] = packColor(color);
 }
 
 bool SRFrameBuffer::saveImage(QString filePath)
 {
-<<<<<<< HEAD
-=======
      std::cout << "it is  SRFrameBuffer::saveImage" << std::endl;
->>>>>>> future
-    return m_colorBuffer.save(filePath);
+    return m_colorTargets[m_frontIndex].image.save(filePath);
 }
 
 void SRFrameBuffer::clearBuffer(const Color& color)
 {
     std::fill(m_depthBuffer.begin(), m_depthBuffer.end(), 1.f); // 深度缓冲填充重置为1
-    m_colorBuffer.fill(QColor(color.x * 255.f, color.y * 255.f, color.z * 255.f)); // 颜色缓冲填充重置
+    std::fill(m_hiZBuffer.begin(), m_hiZBuffer.end(), 1.f);
+    // 颜色缓冲填充重置：行首 32 字节对齐，整块按 8 像素对齐写入
+    __m256i simdClear = _mm256_set1_epi32(static_cast<int>(packColor(color)));
+    uint32_t* data = m_colorData;
+    const size_t total = static_cast<size_t>(m_colorStride) * m_height;
+    for(size_t i = 0; i < total; i += 8){
+        _mm256_store_si256(reinterpret_cast<__m256i*>(data + i), simdClear);
+    }
 }
 
 std::vector<float>& SRFrameBuffer::getDepthBuffer()
@@ -49,7 +102,7 @@ std::vector<float>& SRFrameBuffer::getDepthBuffer()
 
 QImage& SRFrameBuffer::getImage()
 {
-    return m_colorBuffer;
+    return m_colorTargets[m_backIndex].image;
 }
 
 int SRFrameBuffer::getWidth()
@@ -62,160 +115,145 @@ int SRFrameBuffer::getHeight()
     return m_height;
 }
 
-<<<<<<< HEAD
+__m256 SRFrameBuffer::judgeDepthSimd(const __m256& insideMask, int x, int y, const __m256& z_simd, __m256* previousDepth) // 同一行连续8个像素(x ~ x+7)的深度测试
+{
+    // 掩码加载/存储只访问掩码内的像素：行尾越界的像素不会被读取，相邻 tile 的像素也不会被写回
+    float* depthRow = m_depthBuffer.data() + y * m_wide + x;
+    __m256i loadMask = _mm256_castps_si256(insideMask);
+    __m256 currentDepth = _mm256_maskload_ps(depthRow, loadMask);
+    __m256 passMask = _mm256_and_ps(_mm256_cmp_ps(z_simd, currentDepth, _CMP_LT_OQ), insideMask); // z < depth
+    _mm256_maskstore_ps(depthRow, _mm256_castps_si256(passMask), z_simd); // 只写回通过测试的像素
+    if(previousDepth){
+        *previousDepth = currentDepth;
+    }
+    return passMask;
+}
 
-__m256 SRFrameBuffer::judgeDepthSimd(const __m256& inside_mask_ps, const __m256i& x_simd, const __m256i& y_simd, const __m256& z_simd)
-=======
 __m256 SRFrameBuffer::judgeDepthSimd(const __m256& insideMask, const __m256i& x_simd, const __m256i& y_simd, const __m256& z_simd)
->>>>>>> future
-{
-
-    // __m256 epsilon = _mm256_set1_ps(1e-4f);
-    // // 确保 m_wide 和 m_height 可访问
-    // __m256i wide_simd = _mm256_set1_epi32(m_wide);
-    // __m256i height_simd = _mm256_set1_epi32(m_height);
-    // // === 核心修复：钳制 x_simd 和 y_simd，确保索引不越界 ===
-    // // 将 x_simd 钳制到 [0, m_wide-1]
-    // __m256i clamped_x_simd = _mm256_max_epi32(_mm256_setzero_si256(), x_simd);
-    // clamped_x_simd = _mm256_min_epi32(clamped_x_simd, _mm256_sub_epi32(wide_simd, _mm256_set1_epi32(1)));
-    // // 将 y_simd 钳制到 [0, m_height-1]
-    // __m256i clamped_y_simd = _mm256_max_epi32(_mm256_setzero_si256(), y_simd);
-    // clamped_y_simd = _mm256_min_epi32(clamped_y_simd, _mm256_sub_epi32(height_simd, _mm256_set1_epi32(1)));
-    // // === 修正：计算深度缓冲区索引并加载深度值 ===
-    // // 计算每个像素在深度缓冲区中的索引：index = y * m_wide + x
-    // __m256i indices_simd = _mm256_add_epi32(_mm256_mullo_epi32(clamped_y_simd, wide_simd), clamped_x_simd);
-    // // 使用 _mm256_i32gather_ps 从深度缓冲区加载深度值
-    // // base_addr: 深度缓冲区的起始地址 (m_depthBuffer)
-    // // index_simd: 包含要加载元素的索引的 __m256i 向量
-    // // scale: 索引的比例因子，对于 float (4字节) 是 4
-    // // masked_gather: 如果需要根据掩码有条件地加载，可以使用带有掩码的版本
-    // // 这里假设是无条件加载8个位置的深度
-    // __m256 current_depths_simd = _mm256_i32gather_ps(m_depthBuffer.data(), indices_simd, 4); // 或 loadu
-    // __m256 current_depths_threshold = _mm256_sub_ps(current_depths_simd, epsilon);
-    // // === 核心：使用 >= 谓词进行比较，然后取反 ===
-    // // _CMP_GE_OS 表示大于等于 (Greater Than or Equal, Ordered, Signalling)
-    // __m256 ge_mask_ps = _mm256_cmp_ps(z_simd, current_depths_threshold, _CMP_GE_OS);
-    // // 取反掩码：0xFFFFFFFF XOR mask
-    // __m256 all_ones_ps = _mm256_castsi256_ps(_mm256_set1_epi32(0xFFFFFFFF));
-    // __m256 mask_simd = _mm256_xor_ps(all_ones_ps, ge_mask_ps);
-    // return mask_simd;
-
-
-    __m256 depth_test_mask_ps; // 声明掩码
-    // 将 fragment_simd.screenDepth 拆解到数组
-    float temp_screenDepth_arr[8];
-    _mm256_storeu_ps(temp_screenDepth_arr, z_simd);
-    // 遍历这8个像素，逐个进行非SIMD深度测试，并手动构建SIMD掩码
-    int temp_depth_mask_int = 0; // 存储8个像素的深度测试结果位掩码
-    for (int i = 0; i < 8; ++i) {
-        // 只有在三角形内部的像素才进行深度测试
-<<<<<<< HEAD
-        if (((_mm256_movemask_ps(inside_mask_ps) >> i) & 1)) {
-=======
-        if (((_mm256_movemask_ps(insideMask) >> i) & 1)) {
->>>>>>> future
-            int current_x = _mm256_extract_epi32(x_simd, i); // 获取单个像素的x
-            int current_y = _mm256_extract_epi32(y_simd, i); // 获取单个像素的y
-            float current_z = temp_screenDepth_arr[i]; // 获取单个像素的插值深度
-            // 使用非SIMD的深度测试逻辑
-            if (judgeDepth(current_x, current_y, current_z)) {
-                // 如果通过测试，设置对应位
-                temp_depth_mask_int |= (1 << i);
-                // 注意：m_frameBuffer.judgeDepth 内部已经更新了深度缓冲
+{
+    // 8个像素位于同一行且 x 连续时走连续加载路径
+    int x0 = _mm256_cvtsi256_si32(x_simd);
+    int y0 = _mm256_cvtsi256_si32(y_simd);
+    __m256i expectedX = _mm256_add_epi32(_mm256_set1_epi32(x0), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i sameRow = _mm256_and_si256(_mm256_cmpeq_epi32(y_simd, _mm256_set1_epi32(y0)), _mm256_cmpeq_epi32(x_simd, expectedX));
+    if(_mm256_movemask_epi8(sameRow) == -1){
+        return judgeDepthSimd(insideMask, x0, y0, z_simd);
+    }
+
+    // 回退：gather 读取深度，逐个写回通过测试的像素(AVX2 没有 scatter)
+    __m256i indices = _mm256_add_epi32(_mm256_mullo_epi32(y_simd, _mm256_set1_epi32(m_wide)), x_simd);
+    __m256 currentDepth = _mm256_mask_i32gather_ps(_mm256_setzero_ps(), m_depthBuffer.data(), indices, insideMask, 4);
+    __m256 passMask = _mm256_and_ps(_mm256_cmp_ps(z_simd, currentDepth, _CMP_LT_OQ), insideMask);
+    alignas(32) int indexArr[8];
+    alignas(32) float depthArr[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indexArr), indices);
+    _mm256_store_ps(depthArr, z_simd);
+    int mask = _mm256_movemask_ps(passMask);
+    while(mask){
+        int i = __builtin_ctz(mask);
+        mask &= mask - 1;
+        m_depthBuffer[indexArr[i]] = depthArr[i];
+    }
+    return passMask;
+}
+
+bool SRFrameBuffer::judgeHiZOccluded(const CoordI4D& region, float minDepth) const
+{
+    // 遇到第一个可能通过深度测试的块就返回，未被遮挡的三角形通常只检查一两个块
+    for(int by = region[1] / HIZ_BLOCK_SIZE; by <= region[3] / HIZ_BLOCK_SIZE; ++by){
+        const float* hiZRow = m_hiZBuffer.data() + by * m_hiZWide;
+        for(int bx = region[0] / HIZ_BLOCK_SIZE; bx <= region[2] / HIZ_BLOCK_SIZE; ++bx){
+            if(minDepth < hiZRow[bx]){
+                return false;
             }
         }
     }
-    // 将手动构建的整数掩码转换回浮点SIMD掩码
-    // 这需要一个临时 __m256i 向量，然后 cast
-    __m256i temp_depth_mask_simd_i = _mm256_set_epi32(
-        (temp_depth_mask_int >> 7) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 6) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 5) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 4) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 3) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 2) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 1) & 1 ? 0xFFFFFFFF : 0,
-        (temp_depth_mask_int >> 0) & 1 ? 0xFFFFFFFF : 0
-        );
-    return _mm256_castsi256_ps(temp_depth_mask_simd_i);
+    return true;
 }
 
-<<<<<<< HEAD
-void SRFrameBuffer::setPixelSimd(const __m256& mask_simd, const __m256i& x_simd, const __m256i& y_simd, const SimdColor& colors_simd) // colors_simd现在使用SimdVector3D
+void SRFrameBuffer::updateHiZ(int blockXMin, int blockXMax, int blockY)
 {
-
+    int yStart = blockY * HIZ_BLOCK_SIZE;
+    int yEnd = std::min(yStart + HIZ_BLOCK_SIZE, m_height);
+    for(int bx = blockXMin; bx <= blockXMax; ++bx){
+        int xStart = bx * HIZ_BLOCK_SIZE;
+        float maxDepth;
+        if(xStart + HIZ_BLOCK_SIZE <= m_wide){
+            __m256 simdMax = _mm256_set1_ps(-1.f);
+            for(int y = yStart; y < yEnd; ++y){
+                simdMax = _mm256_max_ps(simdMax, _mm256_loadu_ps(m_depthBuffer.data() + y * m_wide + xStart));
+            }
+            // 水平归约出 8 个通道的最大值
+            __m128 lane = _mm_max_ps(_mm256_castps256_ps128(simdMax), _mm256_extractf128_ps(simdMax, 1));
+            lane = _mm_max_ps(lane, _mm_movehl_ps(lane, lane));
+            lane = _mm_max_ss(lane, _mm_shuffle_ps(lane, lane, 1));
+            maxDepth = _mm_cvtss_f32(lane);
+        }
+        else{ // 屏幕右边缘不足 8 列的块
+            maxDepth = -1.f;
+            for(int y = yStart; y < yEnd; ++y){
+                for(int x = xStart; x < m_wide; ++x){
+                    maxDepth = std::max(maxDepth, m_depthBuffer[y * m_wide + x]);
+                }
+            }
+        }
+        m_hiZBuffer[blockY * m_hiZWide + bx] = maxDepth;
+    }
 }
 
-void SRFrameBuffer::updateDepthSimd(const __m256& mask_ps, const __m256i& x_simd, const __m256i& y_simd, const __m256& z_simd)
+void SRFrameBuffer::clearVisibilityBuffer()
 {
-    int current_row_y = _mm256_extract_epi32(y_simd, 0); // 取第一个像素的Y，作为代表行
-    __m256i wide_simd_local = _mm256_set1_epi32(m_wide);
-    __m256i clamped_x_simd = _mm256_max_epi32(_mm256_setzero_si256(), x_simd);
-    clamped_x_simd = _mm256_min_epi32(clamped_x_simd, _mm256_sub_epi32(wide_simd_local, _mm256_set1_epi32(1)));
-    __m256i clamped_y_simd = _mm256_max_epi32(_mm256_setzero_si256(), y_simd);
-    clamped_y_simd = _mm256_min_epi32(clamped_y_simd, _mm256_sub_epi32(_mm256_set1_epi32(m_height), _mm256_set1_epi32(1)));
-    __m256i indices_to_update_simd = _mm256_add_epi32(_mm256_mullo_epi32(clamped_y_simd, wide_simd_local), clamped_x_simd);
-    _mm256_maskstore_ps(m_depthBuffer.data(), indices_to_update_simd, z_simd);
+    m_visibilityBuffer.resize(m_wide * m_height);
+    std::fill(m_visibilityBuffer.begin(), m_visibilityBuffer.end(), VISIBILITY_EMPTY);
 }
-=======
-void SRFrameBuffer::setPixelSIMD(const __m256i& simdX, const __m256i& simdY, const SimdColor& simdColors, __m256& simdMask) // colors_simd现在使用SimdVector3D
+
+void SRFrameBuffer::setVisibilitySimd(int x, int y, uint64_t id, const __m256& mask)
 {
-    __m256i simdHeight = _mm256_set1_epi32(m_height);
-    __m256i oneI = _mm256_set1_epi32(1);
-    __m256i simdFlippedY = _mm256_sub_epi32(_mm256_sub_epi32(simdHeight, oneI), simdY);
+    // 每个 ID 占 64 位，8 个像素分两次按 4 个 64 位通道掩码写入
+    long long* visibilityRow = reinterpret_cast<long long*>(m_visibilityBuffer.data() + y * m_wide + x);
+    __m256i simdId = _mm256_set1_epi64x(static_cast<long long>(id));
+    __m256i mask32 = _mm256_castps_si256(mask);
+    _mm256_maskstore_epi64(visibilityRow, _mm256_cvtepi32_epi64(_mm256_castsi256_si128(mask32)), simdId);
+    _mm256_maskstore_epi64(visibilityRow + 4, _mm256_cvtepi32_epi64(_mm256_extracti128_si256(mask32, 1)), simdId);
+}
 
+void SRFrameBuffer::setPixelSIMD(const __m256i& simdX, const __m256i& simdY, const SimdColor& simdColors, __m256& simdMask) // 只写入掩码内的像素
+{
+    // 与 setPixel 一致：颜色乘 255 后截断，并限制在 [0, 255]
     __m256 float255 = _mm256_set1_ps(255.f);
-    __m256i simdRed = _mm256_cvttps_epi32(_mm256_mul_ps(simdColors.r, float255));
-    __m256i simdGreeen = _mm256_cvttps_epi32(_mm256_mul_ps(simdColors.g, float255));
-    __m256i simdBlue = _mm256_cvttps_epi32(_mm256_mul_ps(simdColors.b, float255));
-
     __m256i simdZero = _mm256_setzero_si256();
     __m256i simd255 = _mm256_set1_epi32(255);
-    simdRed = _mm256_min_epi32(_mm256_max_epi32(simdRed, simdZero), simd255);
-    simdGreeen = _mm256_min_epi32(_mm256_max_epi32(simdGreeen, simdZero), simd255);
-    simdBlue = _mm256_min_epi32(_mm256_max_epi32(simdBlue, simdZero), simd255);
-
-    __m256i simdPixelArgb;
-    simdPixelArgb = _mm256_or_si256(simdRed, _mm256_slli_epi32(simdGreeen, 8));
-    simdPixelArgb = _mm256_or_si256(simdPixelArgb, _mm256_slli_epi32(simdBlue, 16));
-
-    const uchar* scan0 = m_colorBuffer.bits();
-    int bytesPerLine = m_colorBuffer.bytesPerLine();
-    int bytesPerPixel = 4;
-
-    __m256i simdBytPerLine = _mm256_set1_epi32(bytesPerLine);
-    __m256i simdBytPerPixel = _mm256_set1_epi32(bytesPerPixel);
-
-    __m256i addressesOfset = _mm256_add_epi32(_mm256_mullo_epi32(simdFlippedY, simdBytPerLine), _mm256_mullo_epi32(simdX, simdBytPerPixel));
-    __m256i baseAddress = _mm256_set1_epi32(reinterpret_cast<qintptr>(scan0));
-    __m256i absoluteAddresses = _mm256_add_epi32(baseAddress, addressesOfset);
-
-    __m256i pixelIndices = _mm256_srli_epi32(addressesOfset, 2);
-    const int* baseIntPtr = reinterpret_cast<const int*>(scan0);
-    __m256i existingPixel = _mm256_i32gather_epi32(baseIntPtr, pixelIndices, 4);
-    __m256 simdMaskF = simdMask;
-    __m256i simdMaskI = _mm256_castps_si256(simdMaskF);
-    __m256i blendedPixel = _mm256_blendv_epi8(existingPixel, simdPixelArgb, simdMaskI);
-
-    int xArr[8];
-    int yFlippedArr[8];
-    _mm256_storeu_si256((__m256i*)xArr, simdX);
-    _mm256_storeu_si256((__m256i*)yFlippedArr, simdFlippedY);
-    int blendedPixelArr[8];
-    _mm256_storeu_si256((__m256i*)blendedPixelArr, blendedPixel);
+    __m256i simdRed = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(simdColors.r, float255)), simdZero), simd255);
+    __m256i simdGreen = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(simdColors.g, float255)), simdZero), simd255);
+    __m256i simdBlue = _mm256_min_epi32(_mm256_max_epi32(_mm256_cvttps_epi32(_mm256_mul_ps(simdColors.b, float255)), simdZero), simd255);
+    // 打包为 Format_RGB32：0xFFRRGGBB
+    __m256i simdPixel = _mm256_or_si256(simdBlue, _mm256_slli_epi32(simdGreen, 8));
+    simdPixel = _mm256_or_si256(simdPixel, _mm256_slli_epi32(simdRed, 16));
+    simdPixel = _mm256_or_si256(simdPixel, _mm256_set1_epi32(static_cast<int>(0xFF000000u)));
+
+    // 8个像素位于同一行且 x 连续时(光栅化的情况)一次掩码写入
+    int x0 = _mm256_cvtsi256_si32(simdX);
+    int y0 = _mm256_cvtsi256_si32(simdY);
+    __m256i expectedX = _mm256_add_epi32(_mm256_set1_epi32(x0), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+    __m256i sameRow = _mm256_and_si256(_mm256_cmpeq_epi32(simdY, _mm256_set1_epi32(y0)), _mm256_cmpeq_epi32(simdX, expectedX));
+    if(_mm256_movemask_epi8(sameRow) == -1){
+        uint32_t* row = m_colorData + (m_height - 1 - y0) * m_colorStride + x0;
+        _mm256_maskstore_epi32(reinterpret_cast<int*>(row), _mm256_castps_si256(simdMask), simdPixel);
+        return;
+    }
 
+    // 回退：逐个写入掩码内的像素(AVX2 没有 scatter)
+    __m256i simdFlippedY = _mm256_sub_epi32(_mm256_set1_epi32(m_height - 1), simdY);
+    __m256i simdIndex = _mm256_add_epi32(_mm256_mullo_epi32(simdFlippedY, _mm256_set1_epi32(m_colorStride)), simdX);
+    alignas(32) int indexArr[8];
+    alignas(32) uint32_t pixelArr[8];
+    _mm256_store_si256(reinterpret_cast<__m256i*>(indexArr), simdIndex);
+    _mm256_store_si256(reinterpret_cast<__m256i*>(pixelArr), simdPixel);
     int mask = _mm256_movemask_ps(simdMask);
-    for(int i = 0; i < 8; i++){
-        if((mask >> i) & 1){
-            QRgb pixelVal = blendedPixelArr[i];
-            QColor pixelColor;
-            pixelColor.setRgb((pixelVal >> 0) & 0xFF,
-                              (pixelVal >> 8) & 0xFF,
-                              (pixelVal >> 16) & 0xFF);
-
-            m_colorBuffer.setPixelColor(xArr[i], yFlippedArr[i], pixelColor);
-        }
+    while(mask){
+        int i = __builtin_ctz(mask);
+        mask &= mask - 1;
+        m_colorData[indexArr[i]] = pixelArr[i];
     }
 }
 
->>>>>>> future
@@ -2,7 +2,11 @@
 #define SRFRAMEBUFFER_H
 
 #include <iostream>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
 #include <iomanip>
+#include <memory>
 #include <QImage>
 #include <QString>
 #include <vector>
@@ -10,33 +14,80 @@
 #include "BasicDataStructure.h"
 
 
+static constexpr uint64_t VISIBILITY_EMPTY = UINT64_MAX; // 可见性缓冲中没有被任何三角形覆盖的像素
+static constexpr int HIZ_BLOCK_SIZE = 8; // Hi-Z 每个块覆盖 8x8 像素(需整除 TILE_SIZE，保证一个块只属于一个 tile)
+
+// 颜色按 QImage::Format_RGB32 打包：0xFFRRGGBB，分量乘 255 后截断并限制在 [0, 255]
+static inline uint32_t packColor(const Color& color)
+{
+    auto channel = [](float c){ return static_cast<uint32_t>(std::clamp(static_cast<int>(c * 255.f), 0, 255)); };
+    return 0xFF000000u | (channel(color.r) << 16) | (channel(color.g) << 8) | channel(color.b);
+}
+
 class SRFrameBuffer  //帧缓冲
 {
 public:
     SRFrameBuffer(int wide, int height); // 初始化帧缓冲范围
     bool judgeDepth(int x, int y, float z); // 深度判定
     void setPixel(int x, int y, const Color& color); // 像素着色
-    bool saveImage(QString filePath); // 保存缓冲图片
+    bool saveImage(QString filePath); // 保存显示端当前持有的颜色缓冲(单缓冲时即渲染目标)
     void clearBuffer(const Color& color); // 清除缓存
     std::vector<float>& getDepthBuffer();
-    QImage& getImage();
+    QImage& getImage(); // 当前渲染目标
+
+    // 三缓冲：渲染线程写后缓冲，presentColorBuffer() 把写完的一帧与“就绪”缓冲交换；
+    // 显示线程 acquirePresentImage() 时若有新帧则把前缓冲与就绪缓冲交换。双方只交换一个原子下标，互不等待。
+    // count 只能为 1 或 3，须在开始渲染前设置
+    void setColorBufferCount(int count);
+    void presentColorBuffer(); // 渲染线程调用，单缓冲时什么也不做
+    QImage& acquirePresentImage(); // 显示线程调用，返回最近完成的一帧
     int getWidth();
     int getHeight();
 
     //SIMD
-<<<<<<< HEAD
-    __m256 judgeDepthSimd(const __m256& inside_mask_ps,  const __m256i& x_simd, const __m256i& y_simd, const __m256& z_simd);
-    void setPixelSimd(const __m256& mask_simd, const __m256i& x_simd, const __m256i& y_simd, const SimdColor &colors_simd); // colors_simd现在使用SimdVector3D
-    void updateDepthSimd(const __m256& mask_ps, const __m256i& x_simd, const __m256i& y_simd, const __m256& z_simd);
-=======
+    __m256 judgeDepthSimd(const __m256& insideMask, int x, int y, const __m256& z_simd, __m256* previousDepth = nullptr); // 同一行连续8个像素，可取回测试前的深度
     __m256 judgeDepthSimd(const __m256& insideMask,  const __m256i& x_simd, const __m256i& y_simd, const __m256& z_simd);
     void setPixelSIMD(const __m256i& simdX, const __m256i& simdY, const SimdColor &simdColors, __m256 &simdMask);
->>>>>>> future
+    uint32_t* getColorData() { return m_colorData; } // 行按 getColorStride() 个像素对齐，第 0 行为屏幕最上方(y = height - 1)
+    int getColorStride() const { return m_colorStride; }
+
+    // Hi-Z：每个 8x8 块保存块内深度的上界(不小于块内最大深度)
+    float getHiZ(int blockX, int blockY) const { return m_hiZBuffer[blockY * m_hiZWide + blockX]; }
+    bool judgeHiZOccluded(const CoordI4D& region, float minDepth) const; // 区域内所有块的深度上界都 <= minDepth 时返回 true
+    void updateHiZ(int blockXMin, int blockXMax, int blockY); // 按深度缓冲重新计算一行中若干块的最大深度
+
+    // 可见性缓冲：每个像素保存通过深度测试的最近三角形的 ID，只在可见性缓冲模式下分配
+    void clearVisibilityBuffer();
+    void setVisibility(int x, int y, uint64_t id) { m_visibilityBuffer[y * m_wide + x] = id; }
+    void setVisibilitySimd(int x, int y, uint64_t id, const __m256& mask); // 同一行连续8个像素写入同一个 ID
+    const std::vector<uint64_t>& getVisibilityBuffer() const { return m_visibilityBuffer; }
 private:
+    struct AlignedDeleter
+    {
+        void operator()(uint32_t* data) const { _mm_free(data); }
+    };
+    struct ColorTarget
+    {
+        std::unique_ptr<uint32_t[], AlignedDeleter> data; // 32 字节对齐的 Format_RGB32 像素，光栅化直接写入
+        QImage image; // 包装 data 的 QImage(不拷贝)，用于显示和保存
+    };
+    static constexpr int PRESENT_FRESH = 4; // m_readyIndex 中表示就绪缓冲尚未被显示端取走的标志位
+
     int m_wide;
     int m_height;
     std::vector<float> m_depthBuffer;
-    QImage m_colorBuffer;
+    int m_hiZWide;  // Hi-Z 每行的块数
+    int m_hiZHeight;
+    std::vector<float> m_hiZBuffer; // 深度只会减小，因此旧值总是保守的上界
+    std::vector<uint64_t> m_visibilityBuffer;
+    int m_colorStride; // 颜色缓冲每行的像素数，按 8 像素(32 字节)对齐
+    std::vector<ColorTarget> m_colorTargets;
+    int m_backIndex;  // 渲染目标，只由渲染线程访问
+    int m_frontIndex; // 正在显示的缓冲，只由显示线程访问
+    std::atomic<int> m_readyIndex; // 最近完成、等待显示的缓冲(低位为下标，可带 PRESENT_FRESH)
+    uint32_t* m_colorData; // m_colorTargets[m_backIndex] 的像素
+
+    ColorTarget createColorTarget() const;
 };
 
 
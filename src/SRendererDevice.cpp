@@ -1,5 +1,65 @@
 #include "SRendererDevice.h"
 #include "HelperFunction.h"
+#include <chrono>
+#include <climits>
+
+// 当前线程的管线统计槽位，为空表示不统计；由 render() 在分发任务时设置
+static thread_local PipelineStatistics* t_pipelineStats = nullptr;
+
+// 管线阶段计时(仅在开启统计时读取时钟)，exclude 为嵌套在本阶段内、需要扣除的子阶段耗时
+class PipelineStageTimer
+{
+public:
+    PipelineStageTimer(PipelineStatistics* stats, double PipelineStatistics::* stage, double PipelineStatistics::* exclude = nullptr)
+        :m_stats(stats), m_stage(stage), m_exclude(exclude)
+    {
+        if(m_stats){
+            m_excludeStart = m_exclude ? m_stats->*m_exclude : 0.0;
+            m_start = std::chrono::steady_clock::now();
+        }
+    }
+    ~PipelineStageTimer()
+    {
+        if(m_stats){
+            double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - m_start).count();
+            if(m_exclude){
+                ms -= m_stats->*m_exclude - m_excludeStart;
+            }
+            m_stats->*m_stage += ms;
+        }
+    }
+private:
+    PipelineStatistics* m_stats;
+    double PipelineStatistics::* m_stage;
+    double PipelineStatistics::* m_exclude;
+    double m_excludeStart{0.0};
+    std::chrono::steady_clock::time_point m_start;
+};
+
+void PipelineStatistics::merge(const PipelineStatistics& other)
+{
+    meshesSubmitted += other.meshesSubmitted;
+    meshesCulled += other.meshesCulled;
+    meshletsSubmitted += other.meshletsSubmitted;
+    meshletsFrustumCulled += other.meshletsFrustumCulled;
+    meshletsBackfaceCulled += other.meshletsBackfaceCulled;
+    verticesShaded += other.verticesShaded;
+    trianglesSubmitted += other.trianglesSubmitted;
+    trianglesRejected += other.trianglesRejected;
+    trianglesClipped += other.trianglesClipped;
+    trianglesCulled += other.trianglesCulled;
+    pixelsTested += other.pixelsTested;
+    fragmentsInside += other.fragmentsInside;
+    fragmentsDepthPassed += other.fragmentsDepthPassed;
+    fragmentsShaded += other.fragmentsShaded;
+    trianglesHiZRejected += other.trianglesHiZRejected;
+    pixelsHiZRejected += other.pixelsHiZRejected;
+    vertexMs += other.vertexMs;
+    clipMs += other.clipMs;
+    rasterMs += other.rasterMs;
+    shadeMs += other.shadeMs;
+    renderMs += other.renderMs;
+}
 
 EdgeEquation::EdgeEquation(const Triangle& tri)
 {
@@ -159,15 +219,9 @@ __m256i EdgeEquationSimd::judgeInsideTriangleSimd(const SimdVectorI3D& edge_valu
     // (NOT exclude_mask) 等价于 all_ones XOR exclude_mask
     __m256i all_ones = _mm256_set1_epi32(0xFFFFFFFF);
     __m256i not_exclude_mask = _mm256_xor_si256(exclude_mask, all_ones);
-<<<<<<< HEAD
-    __m256i final_inside_mask_simd = _mm256_and_si256(inside_base_mask, not_exclude_mask);
-
-    return final_inside_mask_simd;
-=======
     __m256i final_simdInsideMask = _mm256_and_si256(inside_base_mask, not_exclude_mask);
 
     return final_simdInsideMask;
->>>>>>> future
 }
 
 //--------------------------------------------------------------
@@ -179,18 +233,29 @@ SRendererDevice::SRendererDevice(int wide, int height)
     ,m_lineColor(1.0f)
     ,m_wide(wide)
     ,m_height(height)
-    ,m_threadPool(nullptr)
+    ,m_scheduler(nullptr)
+    ,m_schedulerThreadCount(0)
     ,m_frameBuffer(wide, height)
     ,m_rendererMode(RendererMode::Mesh)
     ,m_faceCulling(true)
     ,m_multiThread(true)
-<<<<<<< HEAD
-    ,m_simd(true)
-=======
     ,m_tbbThread(false)
     ,m_simd(true)
+    ,m_simdShading(true)
     ,m_useFXAA(true)
->>>>>>> future
+    ,m_threadCount(0)
+    ,m_pipelineStats(false)
+    ,m_tileBinning(true)
+    ,m_visibilityBuffer(false)
+    ,m_textureFilter(TextureFilter::TRILINEAR)
+    ,m_textureLayout(TextureLayout::TILED)
+    ,m_frustumCulling(true)
+    ,m_meshletCulling(true)
+    ,m_boundVertexBuffer(INVALID_BUFFER)
+    ,m_drawIndices(nullptr)
+    ,m_tileCountX((wide + TILE_SIZE - 1) / TILE_SIZE)
+    ,m_tileCountY((height + TILE_SIZE - 1) / TILE_SIZE)
+    ,m_visibilityDrawCount(0)
 {
     { // 设置视景体为重心在 (0,0,0) 的 1*1*1立方体
         // near
@@ -217,11 +282,7 @@ SRendererDevice::SRendererDevice(int wide, int height)
         // top
         m_screenLines[3] = {0, -1.f, static_cast<float>(height)}; //（法向量(x,y) + Y偏置）设置可渲染的屏幕高度
     }
-<<<<<<< HEAD
-    m_threadPool = std::make_unique<ThreadPool>(13, 13);
-=======
-    m_threadPool = std::make_unique<ThreadPool>(100, 100);
->>>>>>> future
+    m_scheduler = std::make_unique<TaskScheduler>();
 }
 
 SRendererDevice::~SRendererDevice()
@@ -231,6 +292,7 @@ SRendererDevice::~SRendererDevice()
 void SRendererDevice::clearBuffer()
 {
     m_frameBuffer.clearBuffer(m_clearColor);
+    m_visibilityDrawCount = 0; // 丢弃尚未着色的绘制
 }
 
 QImage& SRendererDevice::getBuffer() // 返回当前帧缓冲内的快照Colorbuffer
@@ -238,83 +300,274 @@ QImage& SRendererDevice::getBuffer() // 返回当前帧缓冲内的快照Colorbu
     return m_frameBuffer.getImage();
 }
 
+QImage& SRendererDevice::getPresentImage()
+{
+    return m_frameBuffer.acquirePresentImage();
+}
+
+void SRendererDevice::presentFrame()
+{
+    m_frameBuffer.presentColorBuffer();
+}
+
 bool SRendererDevice::saveImage(QString path) // 将当前帧缓冲的快照保存到对应路径
 {
-<<<<<<< HEAD
-=======
     std::cout << "it is  SRendererDevice::saveImage" << std::endl;
->>>>>>> future
     return m_frameBuffer.saveImage(path);
 }
 
+template<typename Body>
+void SRendererDevice::parallelExecute(int count, Body&& body) // 管线统计在每个线程内独立计数，结束后合并
+{
+    if(count <= 0){
+        return;
+    }
+    if(m_multiThread){
+        // m_threadCount 改回 <= 0 时同样重建，恢复为 hardware_concurrency 个线程
+        const int threadCount = std::max(0, m_threadCount);
+        if(threadCount != m_schedulerThreadCount){
+            m_scheduler = std::make_unique<TaskScheduler>(threadCount);
+            m_schedulerThreadCount = threadCount;
+        }
+        // 统计按执行线程的队列序号分开计数，同一线程上的区间共用一份
+        if(m_pipelineStats){
+            m_slotStatistics.assign(m_scheduler->getWorkerCount(), PipelineStatistics());
+        }
+        m_scheduler->parallelFor(0, count, [&](int begin, int end){
+            t_pipelineStats = m_pipelineStats ? &m_slotStatistics[m_scheduler->currentSlot()] : nullptr;
+            body(begin, end);
+            t_pipelineStats = nullptr;
+        });
+        if(m_pipelineStats){
+            for(const auto& stats : m_slotStatistics){
+                m_pipelineStatistics.merge(stats);
+            }
+        }
+    }
+    else if(m_tbbThread){
+        tbb::enumerable_thread_specific<PipelineStatistics> threadStats;
+        tbb::parallel_for(tbb::blocked_range<int>(0, count),
+                          [&](const tbb::blocked_range<int>& r)
+                          {
+                              t_pipelineStats = m_pipelineStats ? &threadStats.local() : nullptr;
+                              body(r.begin(), r.end());
+                              t_pipelineStats = nullptr;
+                          });
+        threadStats.combine_each([this](const PipelineStatistics& stats){ m_pipelineStatistics.merge(stats); });
+    }
+    else{
+        t_pipelineStats = m_pipelineStats ? &m_pipelineStatistics : nullptr;
+        body(0, count);
+        t_pipelineStats = nullptr;
+    }
+}
+
 void SRendererDevice::render() // 渲染入口
 {
-    std::vector<Triangle> triangleList;
-    for(int i = 0; i < m_indices.size(); i += 3){
-        assert(i + 1 < m_indices.size() && i + 2 < m_indices.size());
-        triangleList.push_back({
-            m_vertexList.at(m_indices.at(i)),
-            m_vertexList.at(m_indices.at(i + 1)),
-            m_vertexList.at(m_indices.at(i + 2))});
+    auto renderStart = std::chrono::steady_clock::now();
+    assert(m_boundVertexBuffer != INVALID_BUFFER && m_drawIndices && m_drawIndices->size() % 3 == 0);
+    m_shader->updateDrawTransformation();
+    processVertices(); // 每个唯一顶点只做一次顶点着色
+    const int triangleCount = m_drawIndices->size() / 3;
+    const bool visibility = m_visibilityBuffer && m_rendererMode == RendererMode::Rasterization;
+
+    if(visibility){ // 可见性缓冲：三角形保留到帧末，着色推迟到 resolveFrame()
+        if(m_visibilityDrawCount == 0){ // 本帧第一次绘制
+            m_frameBuffer.clearVisibilityBuffer();
+        }
+        if(m_visibilityDraws.size() <= static_cast<size_t>(m_visibilityDrawCount)){
+            m_visibilityDraws.resize(m_visibilityDrawCount + 1);
+        }
+        renderTiled(triangleCount);
+        VisibilityDraw& draw = m_visibilityDraws[m_visibilityDrawCount++];
+        draw.triangles.swap(m_binnedTriangles); // 换回上一帧的容器，保留已分配的容量
+        draw.material = m_shader->m_material;
+    }
+    else if(m_tileBinning && m_rendererMode == RendererMode::Rasterization){ // 分块光栅化入口
+        renderTiled(triangleCount);
+    }
+    else{ // 工作窃取调度器、TBB 或单线程，三角形按需拆分，耗时不均时空闲线程窃取剩余部分
+        parallelExecute(triangleCount, [this](int begin, int end){
+            for(int i = begin; i < end; i++){
+                processTriangle(i);
+            }
+        });
     }
 
-    // 多线程加速入口
-<<<<<<< HEAD
-    if(m_multiThread){
-        // 将模型进行分块加载
-        const int threadCount = m_threadPool->getThreadNum(); // 得到最大线程数量
-        const int chunkSize = triangleList.size() / threadCount; //得到块的大小
-        std::vector<std::future<void>> futures;
-        futures.reserve(threadCount);
-
-        for(int t = 0; t < threadCount; t++){
-            int start = t * chunkSize;
-            int end = (t == threadCount - 1) ? (triangleList.size()) : (start + chunkSize);
-            futures.push_back(m_threadPool->addTask([this, start, end, &triangleList](){
-                for(int i = start; i < end; i++){
-                    this->processTriangle(triangleList[i]);
-                }
-            }));
-        }
-        for(auto& future : futures){
-            future.get();
-=======
-    if(m_multiThread || m_tbbThread){
-        if(m_multiThread){
-            //将模型进行分块加载
-            const int threadCount = m_threadPool->getThreadNum(); // 得到最大线程数量
-            const int chunkSize = triangleList.size() / threadCount; //得到块的大小
-            std::vector<std::future<void>> futures;
-            futures.reserve(threadCount);
-
-            for(int t = 0; t < threadCount; t++){
-                int start = t * chunkSize;
-                int end = (t == threadCount - 1) ? (triangleList.size()) : (start + chunkSize);
-                futures.push_back(m_threadPool->addTask([this, start, end, &triangleList](){
-                    for(int i = start; i < end; i++){
-                        this->processTriangle(triangleList[i]);
-                    }
-                }));
+    if(m_pipelineStats){
+        m_pipelineStatistics.renderMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - renderStart).count();
+    }
+}
+
+namespace {
+template<typename Resource>
+BufferHandle allocateResource(std::vector<Resource>& table, ResourceSlots& slots, Resource&& resource)
+{
+    BufferHandle handle;
+    if(slots.freeList.empty()){
+        table.push_back(std::move(resource));
+        handle = static_cast<BufferHandle>(table.size() - 1);
+    }
+    else{
+        handle = slots.freeList.back();
+        slots.freeList.pop_back();
+        table[handle] = std::move(resource);
+    }
+    slots.live.resize(table.size(), 0);
+    slots.live[handle] = 1;
+    return handle;
+}
+
+template<typename Resource>
+void releaseResource(std::vector<Resource>& table, ResourceSlots& slots, BufferHandle handle)
+{
+    if(handle < 0 || handle >= static_cast<BufferHandle>(slots.live.size()) || !slots.live[handle]){
+        return; // 无效句柄或重复释放：若再次放入空闲列表，之后两次创建会得到同一个位置
+    }
+    table[handle] = Resource(); // 立即释放数据，位置留给之后创建的资源
+    slots.live[handle] = 0;
+    slots.freeList.push_back(handle);
+}
+} // namespace
+
+BufferHandle SRendererDevice::createVertexBuffer(std::vector<Vertex> vertices)
+{
+    VertexBuffer buffer;
+    buffer.stream.assign(vertices);
+    buffer.vertices = std::move(vertices);
+    return allocateResource(m_vertexBuffers, m_vertexBufferSlots, std::move(buffer));
+}
+
+BufferHandle SRendererDevice::createIndexBuffer(std::vector<unsigned> indices)
+{
+    return allocateResource(m_indexBuffers, m_indexBufferSlots, std::move(indices));
+}
+
+BufferHandle SRendererDevice::createTexture(Texture texture)
+{
+    return allocateResource(m_textureList, m_textureSlots, std::move(texture));
+}
+
+void SRendererDevice::releaseVertexBuffer(BufferHandle handle)
+{
+    if(handle == m_boundVertexBuffer){
+        m_boundVertexBuffer = INVALID_BUFFER;
+    }
+    releaseResource(m_vertexBuffers, m_vertexBufferSlots, handle);
+}
+
+void SRendererDevice::releaseIndexBuffer(BufferHandle handle)
+{
+    if(handle >= 0 && handle < static_cast<BufferHandle>(m_indexBuffers.size()) && m_drawIndices == &m_indexBuffers[handle]){
+        m_drawIndices = nullptr; // 只解除对被释放缓冲的引用，其他网格的绑定不受影响
+    }
+    releaseResource(m_indexBuffers, m_indexBufferSlots, handle);
+}
+
+void SRendererDevice::releaseTexture(BufferHandle handle)
+{
+    releaseResource(m_textureList, m_textureSlots, handle);
+}
+
+void SRendererDevice::bindVertexBuffer(BufferHandle handle)
+{
+    m_boundVertexBuffer = handle;
+}
+
+bool SRendererDevice::isMeshVisible(const Coord3D& aabbMin, const Coord3D& aabbMax, const Coord3D& centre, float radius)
+{
+    if(m_pipelineStats){
+        m_pipelineStatistics.meshesSubmitted++;
+    }
+    if(!m_frustumCulling){
+        return true;
+    }
+    bool visible = true;
+    for(const BorderPlane& plane : getModelSpaceViewPlanes()){
+        const Vector3D normal(plane);
+        if(glm::dot(normal, centre) + plane.w < -radius * glm::length(normal)){
+            visible = false;
+            break;
+        }
+        // 包围球与平面相交时再取 AABB 在法线方向上最远的角点
+        const Coord3D farthest(normal.x >= 0.f ? aabbMax.x : aabbMin.x,
+                               normal.y >= 0.f ? aabbMax.y : aabbMin.y,
+                               normal.z >= 0.f ? aabbMax.z : aabbMin.z);
+        if(glm::dot(normal, farthest) + plane.w < 0.f){
+            visible = false;
+            break;
+        }
+    }
+    if(!visible && m_pipelineStats){
+        m_pipelineStatistics.meshesCulled++;
+    }
+    return visible;
+}
+
+bool SRendererDevice::cullMeshlets(const std::vector<Meshlet>& meshlets, BufferHandle indexBuffer)
+{
+    const std::vector<unsigned>& indices = m_indexBuffers[indexBuffer];
+    const size_t vertexCount = m_vertexBuffers[m_boundVertexBuffer].vertices.size();
+    m_vertexGroupMask.clear();
+    if(!m_meshletCulling || meshlets.empty()){
+        m_drawIndices = &indices;
+        return !indices.empty();
+    }
+    const std::array<BorderPlane, 6> planes = getModelSpaceViewPlanes();
+    // 只有光栅化且开启面剔除时背面三角形才会被丢弃，线框与顶点模式仍要画出背面
+    const bool backface = m_faceCulling && m_rendererMode == RendererMode::Rasterization;
+    const Coord3D eye = glm::inverse(m_shader->m_viewTransformation * m_shader->m_modelTransformation) * Coord4D(0.f, 0.f, 0.f, 1.f);
+
+    unsigned long long frustumCulled = 0;
+    unsigned long long backfaceCulled = 0;
+    m_culledIndices.clear();
+    m_drawIndices = &m_culledIndices;
+    for(const Meshlet& meshlet : meshlets){
+        bool visible = true;
+        for(const BorderPlane& plane : planes){
+            if(glm::dot(Vector3D(plane), meshlet.centre) + plane.w < -meshlet.radius * glm::length(Vector3D(plane))){
+                visible = false;
+                break;
             }
-            for(auto& future : futures){
-                future.get();
+        }
+        if(!visible){
+            frustumCulled++;
+            continue;
+        }
+        // 包围球内任意一点看向 meshlet 的方向都落在法线锥的背面一侧时，所有三角形都是背面
+        if(backface && meshlet.coneCutoff < 1.f){
+            const Vector3D view = meshlet.centre - eye;
+            if(glm::dot(view, meshlet.coneAxis) >= meshlet.coneCutoff * glm::length(view) + meshlet.radius){
+                backfaceCulled++;
+                continue;
             }
-        }else if(m_tbbThread){
-            tbb::parallel_for(tbb::blocked_range<size_t>(0, triangleList.size()),
-                              [&](tbb::blocked_range<size_t> r)
-                              {
-                                  for(size_t i = r.begin(); i < r.end(); i++)
-                                      processTriangle(triangleList[i]);
-                              });
->>>>>>> future
         }
+        auto first = indices.begin() + 3 * meshlet.triangleOffset;
+        m_culledIndices.insert(m_culledIndices.end(), first, first + 3 * meshlet.triangleCount);
     }
-    else // 非多线程入口
-    {
-        for(int i = 0; i < triangleList.size(); i++){
-            processTriangle(triangleList[i]);
+    if(m_pipelineStats){
+        m_pipelineStatistics.meshletsSubmitted += meshlets.size();
+        m_pipelineStatistics.meshletsFrustumCulled += frustumCulled;
+        m_pipelineStatistics.meshletsBackfaceCulled += backfaceCulled;
+    }
+    if(!m_culledIndices.empty() && m_culledIndices.size() < indices.size()){
+        m_vertexGroupMask.assign((vertexCount + 7) / 8, 0);
+        for(unsigned index : m_culledIndices){
+            m_vertexGroupMask[index >> 3] = 1;
         }
     }
+    return !m_culledIndices.empty();
+}
+
+std::array<BorderPlane, 6> SRendererDevice::getModelSpaceViewPlanes() const
+{
+    // 裁剪空间中 dot(plane, MVP * p) >= 0 为内侧，等价于模型空间平面 transpose(MVP) * plane
+    const glm::mat4 mvpTranspose = glm::transpose(m_shader->m_projectionTransformation * m_shader->m_viewTransformation * m_shader->m_modelTransformation);
+    std::array<BorderPlane, 6> planes;
+    for(int i = 0; i < 6; i++){
+        planes[i] = mvpTranspose * m_viewPlanes[i];
+    }
+    return planes;
 }
 
 void SRendererDevice::init(int& wide, int& height)
@@ -327,68 +580,399 @@ SRendererDevice& SRendererDevice::getInstance(int wide, int height) // 获取一
     static SRendererDevice Instance(wide, height);
     return Instance;
 }
-<<<<<<< HEAD
-=======
 
 SRFrameBuffer& SRendererDevice::getFrameBuffer()
 {
     return m_frameBuffer;
 }
->>>>>>> future
+
+const PipelineStatistics& SRendererDevice::getPipelineStatistics() const
+{
+    return m_pipelineStatistics;
+}
+
+void SRendererDevice::resetPipelineStatistics()
+{
+    m_pipelineStatistics = PipelineStatistics();
+}
 //------------------------------------------
 // private
-void SRendererDevice::processTriangle(Triangle& tri) // 处理传入的三角形
+int SRendererDevice::getWorkerCount() const
 {
-    for(int i = 0; i< 3; i++) // 遍历三角形的顶点
+    if(m_multiThread){
+        return m_threadCount > 0 ? m_threadCount : m_scheduler->getWorkerCount();
+    }
+    if(m_tbbThread){
+        return tbb::this_task_arena::max_concurrency();
+    }
+    return 1;
+}
+
+void SRendererDevice::processVertices()
+{
+    const std::vector<Vertex>& vertices = m_vertexBuffers[m_boundVertexBuffer].vertices;
+    const int vertexCount = vertices.size();
+    m_transformedVertices.resize(vertexCount);
+    const int blockCount = (vertexCount + VERTEX_BLOCK_SIZE - 1) / VERTEX_BLOCK_SIZE;
+    const bool useSimd = m_simd;
+    const bool masked = !m_vertexGroupMask.empty();
+    parallelExecute(blockCount, [this, &vertices, vertexCount, useSimd, masked](int firstBlock, int lastBlock){
+        PipelineStageTimer timer(t_pipelineStats, &PipelineStatistics::vertexMs);
+        int start = firstBlock * VERTEX_BLOCK_SIZE;
+        int end = std::min(lastBlock * VERTEX_BLOCK_SIZE, vertexCount);
+        int shaded = 0;
+        for(int group = start; group < end; group += 8){ // 以8个顶点为一组，跳过被剔除 meshlet 独占的顶点组
+            if(masked && !m_vertexGroupMask[group >> 3]){
+                continue;
+            }
+            int groupEnd = std::min(group + 8, end);
+            if(useSimd){
+                processVerticesSimd(group, groupEnd);
+            }
+            else{
+                for(int i = group; i < groupEnd; i++){
+                    m_transformedVertices[i] = vertices[i];
+                    m_shader->vertexShader(m_transformedVertices[i]); // 对顶点应用顶点处理(变换)
+                }
+            }
+            shaded += groupEnd - group;
+        }
+        if(t_pipelineStats){
+            t_pipelineStats->verticesShaded += shaded;
+        }
+    });
+    m_vertexGroupMask.clear(); // 掩码只对应本次绘制
+}
+
+void SRendererDevice::processVerticesSimd(int start, int end) // start 须为8的倍数
+{
+    const VertexStream& stream = m_vertexBuffers[m_boundVertexBuffer].stream;
+    for(int i = start; i < end; i += 8){
+        SimdVertex vertex;
+        vertex.worldSpacePos = {_mm256_loadu_ps(&stream.posX[i]), _mm256_loadu_ps(&stream.posY[i]), _mm256_loadu_ps(&stream.posZ[i])};
+        vertex.normal = {_mm256_loadu_ps(&stream.normalX[i]), _mm256_loadu_ps(&stream.normalY[i]), _mm256_loadu_ps(&stream.normalZ[i])};
+        vertex.texCoord = {_mm256_loadu_ps(&stream.texU[i]), _mm256_loadu_ps(&stream.texV[i])};
+        m_shader->vertexShaderSIMD(vertex);
+
+        // 转回 AoS 写入顶点着色缓冲，供图元装配使用
+        alignas(32) float worldX[8], worldY[8], worldZ[8];
+        alignas(32) float clipX[8], clipY[8], clipZ[8], clipW[8];
+        alignas(32) float normalX[8], normalY[8], normalZ[8];
+        alignas(32) float texU[8], texV[8];
+        _mm256_store_ps(worldX, vertex.worldSpacePos.x);
+        _mm256_store_ps(worldY, vertex.worldSpacePos.y);
+        _mm256_store_ps(worldZ, vertex.worldSpacePos.z);
+        _mm256_store_ps(clipX, vertex.clipSpacePos.x);
+        _mm256_store_ps(clipY, vertex.clipSpacePos.y);
+        _mm256_store_ps(clipZ, vertex.clipSpacePos.z);
+        _mm256_store_ps(clipW, vertex.clipSpacePos.w);
+        _mm256_store_ps(normalX, vertex.normal.x);
+        _mm256_store_ps(normalY, vertex.normal.y);
+        _mm256_store_ps(normalZ, vertex.normal.z);
+        _mm256_store_ps(texU, vertex.texCoord.x);
+        _mm256_store_ps(texV, vertex.texCoord.y);
+        const int count = std::min(8, end - i);
+        for(int k = 0; k < count; k++){
+            Vertex& out = m_transformedVertices[i + k];
+            out.worldSpacePos = {worldX[k], worldY[k], worldZ[k]};
+            out.clipSpacePos = {clipX[k], clipY[k], clipZ[k], clipW[k]};
+            out.normal = {normalX[k], normalY[k], normalZ[k]};
+            out.texCoord = {texU[k], texV[k]};
+        }
+    }
+}
+
+void SRendererDevice::renderTiled(int triangleCount)
+{
+    // 前端：各分块并行完成图元装配、裁剪和屏幕映射，并把三角形分箱到其包围盒覆盖的 tile
+    int chunkCount = std::max(1, std::min(getWorkerCount(), triangleCount));
+    if(m_visibilityBuffer){
+        chunkCount = std::min(chunkCount, MAX_VISIBILITY_CHUNKS); // 分块号需要放进可见性 ID
+    }
+    const int chunkSize = triangleCount / chunkCount;
+    m_binnedTriangles.resize(chunkCount);
+    m_tileBins.resize(chunkCount);
+    parallelExecute(chunkCount, [&](int firstChunk, int lastChunk){
+        for(int c = firstChunk; c < lastChunk; c++){
+            m_binnedTriangles[c].clear();
+            m_tileBins[c].resize(m_tileCountX * m_tileCountY);
+            for(auto& bin : m_tileBins[c]){
+                bin.clear();
+            }
+            int start = c * chunkSize;
+            int end = (c == chunkCount - 1) ? triangleCount : (start + chunkSize);
+            for(int i = start; i < end; i++){
+                processTriangle(i, c);
+            }
+        }
+    });
+    // 后端：以 tile 为单位并行光栅化，每个像素只有一个写入线程，深度测试无需加锁
+    parallelExecute(m_tileCountX * m_tileCountY, [this](int firstTile, int lastTile){
+        for(int tile = firstTile; tile < lastTile; tile++){
+            rasterizationTile(tile);
+        }
+    });
+}
+
+void SRendererDevice::binTriangle(Triangle& tri, int chunk)
+{
+    EdgeEquation triEdge(tri);
+    if((m_faceCulling && triEdge.m_twoArea <= 0) || triEdge.m_twoArea == 0) // 与 rasterizationTriangle 相同的剔除条件
     {
-        m_shader->vertexShader(tri[i]);  // 对顶点应用顶点处理(变换)
+        if(t_pipelineStats){
+            t_pipelineStats->trianglesCulled++;
+        }
+        return;
     }
+    CoordI4D boundingBox = getBoundingBox(tri);
+    if(boundingBox[0] > boundingBox[2] || boundingBox[1] > boundingBox[3]) // 完全在屏幕外
+    {
+        return;
+    }
+    unsigned index = m_binnedTriangles[chunk].size();
+    assert(!m_visibilityBuffer || index < (1u << VISIBILITY_CHUNK_SHIFT)); // 下标需要放进可见性 ID
+    m_binnedTriangles[chunk].push_back(tri);
+    auto& bins = m_tileBins[chunk];
+    for(int ty = boundingBox[1] / TILE_SIZE; ty <= boundingBox[3] / TILE_SIZE; ty++){
+        for(int tx = boundingBox[0] / TILE_SIZE; tx <= boundingBox[2] / TILE_SIZE; tx++){
+            bins[ty * m_tileCountX + tx].push_back(index);
+        }
+    }
+}
 
-    if(m_faceCulling){
-        std::vector<Triangle> completedTriangleList = clipTriangle(tri); // 剪裁三角形
+void SRendererDevice::rasterizationTile(int tile)
+{
+    int tx = tile % m_tileCountX;
+    int ty = tile / m_tileCountX;
+    CoordI4D region = {
+        tx * TILE_SIZE,
+        ty * TILE_SIZE,
+        std::min(m_wide, (tx + 1) * TILE_SIZE) - 1,
+        std::min(m_height, (ty + 1) * TILE_SIZE) - 1
+    };
+    PipelineStageTimer timer(t_pipelineStats, &PipelineStatistics::rasterMs, &PipelineStatistics::shadeMs);
+    const bool visibility = m_visibilityBuffer && m_rendererMode == RendererMode::Rasterization;
+    for(size_t c = 0; c < m_tileBins.size(); c++) // 分块按提交顺序排列，保证与立即模式相同的绘制顺序
+    {
+        for(unsigned index : m_tileBins[c][tile]){
+            uint64_t visibilityId = VISIBILITY_EMPTY;
+            if(visibility){
+                visibilityId = (static_cast<uint64_t>(m_visibilityDrawCount) << 32) | (c << VISIBILITY_CHUNK_SHIFT) | index;
+            }
+            rasterizationTriangle(m_binnedTriangles[c][index], region, visibilityId);
+        }
+    }
+}
 
-        for (auto &ctri : completedTriangleList){
-            executePerspectiveDivision(ctri); // 透视除法
-            convertToScreen(ctri); // 转换为屏幕坐标
-            if(m_rendererMode == RendererMode::Rasterization) // 应用光栅化
-            {
-                rasterizationTriangle(ctri);
+void SRendererDevice::resolveFrame()
+{
+    if(m_visibilityDrawCount == 0){
+        return;
+    }
+    auto resolveStart = std::chrono::steady_clock::now();
+    const int tileCount = m_tileCountX * m_tileCountY;
+    const size_t offsetStride = m_visibilityDrawCount + 1;
+    m_resolvePixels.resize(static_cast<size_t>(tileCount) * TILE_SIZE * TILE_SIZE);
+    m_resolveOffsets.resize(tileCount * offsetStride);
+    parallelExecute(tileCount, [this](int firstTile, int lastTile){
+        for(int tile = firstTile; tile < lastTile; tile++){
+            groupVisiblePixels(tile);
+        }
+    });
+
+    // 材质是着色器的共享状态，因此逐个绘制设置材质，再按 tile 并行着色
+    Material frameMaterial = m_shader->m_material;
+    for(int draw = 0; draw < m_visibilityDrawCount; draw++){
+        bool visible = false;
+        for(int tile = 0; tile < tileCount && !visible; tile++){
+            const unsigned* offsets = &m_resolveOffsets[tile * offsetStride];
+            visible = offsets[draw + 1] > offsets[draw];
+        }
+        if(!visible){
+            continue;
+        }
+        m_shader->m_material = m_visibilityDraws[draw].material;
+        parallelExecute(tileCount, [this, draw](int firstTile, int lastTile){
+            for(int tile = firstTile; tile < lastTile; tile++){
+                resolveTile(tile, draw);
             }
-            else if(m_rendererMode == RendererMode::Mesh) // 仅画出线框图
-            {
-                wireFrameTriangle(ctri);
+        });
+    }
+    m_shader->m_material = frameMaterial;
+    m_visibilityDrawCount = 0;
+
+    if(m_pipelineStats){
+        m_pipelineStatistics.renderMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - resolveStart).count();
+    }
+}
+
+void SRendererDevice::groupVisiblePixels(int tile)
+{
+    const int tx = tile % m_tileCountX;
+    const int ty = tile / m_tileCountX;
+    const int xEnd = std::min(m_wide, (tx + 1) * TILE_SIZE);
+    const int yEnd = std::min(m_height, (ty + 1) * TILE_SIZE);
+    const size_t offsetStride = m_visibilityDrawCount + 1;
+    const std::vector<uint64_t>& visibility = m_frameBuffer.getVisibilityBuffer();
+    unsigned* offsets = &m_resolveOffsets[tile * offsetStride];
+    unsigned* pixels = &m_resolvePixels[static_cast<size_t>(tile) * TILE_SIZE * TILE_SIZE];
+
+    // 计数排序：先统计每个绘制的可见像素数，前缀和得到起始位置，再按行序写入像素下标
+    std::fill(offsets, offsets + offsetStride, 0u);
+    for(int y = ty * TILE_SIZE; y < yEnd; y++){
+        for(int x = tx * TILE_SIZE; x < xEnd; x++){
+            uint64_t id = visibility[y * m_wide + x];
+            if(id != VISIBILITY_EMPTY){
+                offsets[(id >> 32) + 1]++;
             }
-            else if(m_rendererMode == RendererMode::VERTEX) // 仅画出顶点图
-            {
-                pointTriangle(ctri);
+        }
+    }
+    for(size_t draw = 1; draw < offsetStride; draw++){
+        offsets[draw] += offsets[draw - 1];
+    }
+    std::vector<unsigned> cursor(offsets, offsets + offsetStride - 1);
+    for(int y = ty * TILE_SIZE; y < yEnd; y++){
+        for(int x = tx * TILE_SIZE; x < xEnd; x++){
+            uint64_t id = visibility[y * m_wide + x];
+            if(id != VISIBILITY_EMPTY){
+                pixels[cursor[id >> 32]++] = y * m_wide + x;
             }
-<<<<<<< HEAD
         }
     }
-    else{
-        executePerspectiveDivision(tri); // 透视除法
-        convertToScreen(tri); // 转换为屏幕坐标
-        if(m_rendererMode == RendererMode::Rasterization) // 应用光栅化
-        {
-            rasterizationTriangle(tri);
+}
+
+void SRendererDevice::resolveTile(int tile, int draw)
+{
+    const unsigned* offsets = &m_resolveOffsets[tile * (m_visibilityDrawCount + 1)];
+    const unsigned begin = offsets[draw];
+    const unsigned end = offsets[draw + 1];
+    if(begin == end){
+        return;
+    }
+    const unsigned* pixels = &m_resolvePixels[static_cast<size_t>(tile) * TILE_SIZE * TILE_SIZE];
+    const std::vector<uint64_t>& visibility = m_frameBuffer.getVisibilityBuffer();
+    const std::vector<float>& depthBuffer = m_frameBuffer.getDepthBuffer();
+    const auto& triangles = m_visibilityDraws[draw].triangles;
+    auto visibleTriangle = [&](unsigned pixel) -> const Triangle& {
+        uint64_t id = visibility[pixel];
+        return triangles[(id >> VISIBILITY_CHUNK_SHIFT) & (MAX_VISIBILITY_CHUNKS - 1)][id & ((1u << VISIBILITY_CHUNK_SHIFT) - 1)];
+    };
+    PipelineStatistics* stats = t_pipelineStats;
+    PipelineStageTimer timer(stats, &PipelineStatistics::shadeMs);
+    if(stats){
+        stats->fragmentsShaded += end - begin;
+    }
+
+    if(!m_simd || !m_simdShading){
+        for(unsigned i = begin; i < end; i++){
+            const int x = pixels[i] % m_wide;
+            const int y = pixels[i] / m_wide;
+            const Triangle& tri = visibleTriangle(pixels[i]);
+            Vector3D barycentric = getScreenBarycentric(tri, x, y);
+            float viewDepth = 1.f / (barycentric.x / tri[0].ndcSpacePos.w + barycentric.y / tri[1].ndcSpacePos.w + barycentric.z / tri[2].ndcSpacePos.w);
+            Fragment frag = constructFragment(x, y, depthBuffer[pixels[i]], viewDepth, tri, barycentric);
+            setTexCoordDerivatives(frag, getTexCoordGradient(tri), viewDepth);
+            m_shader->fragmentShader(frag);
+            m_frameBuffer.setPixel(x, y, frag.fragmentColor);
         }
-        else if(m_rendererMode == RendererMode::Mesh) // 仅画出线框图
-        {
-            wireFrameTriangle(tri);
+        return;
+    }
+
+    // 8 个可见像素一组：逐通道按各自的三角形插值 属性/w 与 1/w，再整体做透视校正和 SIMD 着色
+    for(unsigned i = begin; i < end; i += 8){
+        const int count = std::min(8u, end - i);
+        alignas(32) int xArr[8] = {}, yArr[8] = {};
+        alignas(32) float depthArr[8] = {}, wRecipArr[8] = {1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f, 1.f};
+        alignas(32) float texArr[2][8] = {}, normalArr[3][8] = {}, posArr[3][8] = {};
+        alignas(32) float texDxArr[2][8] = {}, texDyArr[2][8] = {};
+        alignas(32) int laneMask[8] = {};
+        for(int lane = 0; lane < count; lane++){
+            const unsigned pixel = pixels[i + lane];
+            const Triangle& tri = visibleTriangle(pixel);
+            xArr[lane] = pixel % m_wide;
+            yArr[lane] = pixel / m_wide;
+            depthArr[lane] = depthBuffer[pixel];
+            laneMask[lane] = -1;
+            Vector3D b = getScreenBarycentric(tri, xArr[lane], yArr[lane]);
+            const float w0 = tri[0].ndcSpacePos.w, w1 = tri[1].ndcSpacePos.w, w2 = tri[2].ndcSpacePos.w;
+            wRecipArr[lane] = (1.f / w0) * b.x + (1.f / w1) * b.y + (1.f / w2) * b.z;
+            Coord2D tex = (tri[0].texCoord / w0) * b.x + (tri[1].texCoord / w1) * b.y + (tri[2].texCoord / w2) * b.z;
+            Vector3D normal = (tri[0].normal / w0) * b.x + (tri[1].normal / w1) * b.y + (tri[2].normal / w2) * b.z;
+            Coord3D pos = (tri[0].worldSpacePos / w0) * b.x + (tri[1].worldSpacePos / w1) * b.y + (tri[2].worldSpacePos / w2) * b.z;
+            texArr[0][lane] = tex.x;
+            texArr[1][lane] = tex.y;
+            // 各通道可能属于不同三角形，纹理坐标导数逐通道由所属三角形的梯度求出
+            const TexCoordGradient grad = getTexCoordGradient(tri);
+            const float w = 1.f / wRecipArr[lane];
+            const Coord2D uv = tex * w;
+            texDxArr[0][lane] = (grad.uDx - uv.x * grad.wDx) * w;
+            texDxArr[1][lane] = (grad.vDx - uv.y * grad.wDx) * w;
+            texDyArr[0][lane] = (grad.uDy - uv.x * grad.wDy) * w;
+            texDyArr[1][lane] = (grad.vDy - uv.y * grad.wDy) * w;
+            for(int k = 0; k < 3; k++){
+                normalArr[k][lane] = normal[k];
+                posArr[k][lane] = pos[k];
+            }
         }
-        else if(m_rendererMode == RendererMode::VERTEX) // 仅画出顶点图
+        SimdFragment simdFragment;
+        simdFragment.screenPosX = _mm256_load_si256(reinterpret_cast<const __m256i*>(xArr));
+        simdFragment.screenPosY = _mm256_load_si256(reinterpret_cast<const __m256i*>(yArr));
+        simdFragment.screenDepth = _mm256_load_ps(depthArr);
+        simdFragment.viewDepth = _mm256_load_ps(wRecipArr);
+        simdFragment.texCoord = {_mm256_load_ps(texArr[0]), _mm256_load_ps(texArr[1])};
+        simdFragment.normal = {_mm256_load_ps(normalArr[0]), _mm256_load_ps(normalArr[1]), _mm256_load_ps(normalArr[2])};
+        simdFragment.worldSpacePos = {_mm256_load_ps(posArr[0]), _mm256_load_ps(posArr[1]), _mm256_load_ps(posArr[2])};
+        correctPerspectiveSimd(simdFragment);
+        simdFragment.texCoordDx = {_mm256_load_ps(texDxArr[0]), _mm256_load_ps(texDxArr[1])};
+        simdFragment.texCoordDy = {_mm256_load_ps(texDyArr[0]), _mm256_load_ps(texDyArr[1])};
+        __m256 mask = _mm256_castsi256_ps(_mm256_load_si256(reinterpret_cast<const __m256i*>(laneMask)));
+        m_shader->fragmentShaderSIMD(simdFragment, mask);
+        m_frameBuffer.setPixelSIMD(simdFragment.screenPosX, simdFragment.screenPosY, simdFragment.fragmentColor, mask);
+    }
+}
+
+void SRendererDevice::processTriangle(int index, int binChunk) // 从顶点着色缓冲中装配并处理三角形
+{
+    PipelineStatistics* stats = t_pipelineStats;
+    if(stats){
+        stats->trianglesSubmitted++;
+    }
+    Triangle tri = {
+        m_transformedVertices[(*m_drawIndices)[3 * index]],
+        m_transformedVertices[(*m_drawIndices)[3 * index + 1]],
+        m_transformedVertices[(*m_drawIndices)[3 * index + 2]]};
+
+    if(m_faceCulling){
+        std::vector<Triangle> completedTriangleList;
         {
-            pointTriangle(tri);
+            PipelineStageTimer timer(stats, &PipelineStatistics::clipMs);
+            completedTriangleList = clipTriangle(tri); // 剪裁三角形
+        }
+        for (auto &ctri : completedTriangleList){
+            drawTriangle(ctri, binChunk);
         }
-=======
+        return;
+    }
+    drawTriangle(tri, binChunk);
+}
+
+void SRendererDevice::drawTriangle(Triangle& tri, int binChunk) // 透视除法、屏幕映射后按渲染模式绘制
+{
+    PipelineStatistics* stats = t_pipelineStats;
+    {
+        PipelineStageTimer timer(stats, &PipelineStatistics::clipMs);
+        executePerspectiveDivision(tri); // 透视除法
+        convertToScreen(tri); // 转换为屏幕坐标
+        if(binChunk >= 0) // 分块光栅化：只分箱，稍后按 tile 光栅化
+        {
+            binTriangle(tri, binChunk);
             return;
         }
     }
-    executePerspectiveDivision(tri); // 透视除法
-    convertToScreen(tri); // 转换为屏幕坐标
+    PipelineStageTimer timer(stats, &PipelineStatistics::rasterMs, &PipelineStatistics::shadeMs);
     if(m_rendererMode == RendererMode::Rasterization) // 应用光栅化
     {
-        rasterizationTriangle(tri);
+        rasterizationTriangle(tri, {0, 0, m_wide - 1, m_height - 1});
     }
     else if(m_rendererMode == RendererMode::Mesh) // 仅画出线框图
     {
@@ -397,83 +981,33 @@ void SRendererDevice::processTriangle(Triangle& tri) // 处理传入的三角形
     else if(m_rendererMode == RendererMode::VERTEX) // 仅画出顶点图
     {
         pointTriangle(tri);
->>>>>>> future
     }
 }
 
-void SRendererDevice::rasterizationTriangle(Triangle& tri) // 光栅化三角形
+void SRendererDevice::rasterizationTriangle(Triangle& tri, const CoordI4D& region, uint64_t visibilityId) // 光栅化三角形
 {
     EdgeEquation triEdge(tri);
-    if(m_faceCulling && triEdge.m_twoArea <= 0) // 若三角形非法(不存在)直接返回
-    {
-        return;
-    }
-<<<<<<< HEAD
-    else if(triEdge.m_twoArea == 0) // 若三角形为一条线直接返回
-=======
-    if(triEdge.m_twoArea == 0) // 若三角形为一条线直接返回
->>>>>>> future
+    PipelineStatistics* stats = t_pipelineStats;
+    if((m_faceCulling && triEdge.m_twoArea <= 0) || triEdge.m_twoArea == 0) // 若三角形为背面或退化为一条线直接返回
     {
+        if(stats){
+            stats->trianglesCulled++;
+        }
         return;
     }
 
-<<<<<<< HEAD
-    if(m_simd){
-        rasterizationTriangleSimd(tri);
-    }
-    else{
-        CoordI4D boundingBox = getBoundingBox(tri); // 求三角形的包围盒
-        int xMin = std::max(0, boundingBox[0]);
-        int yMin = std::max(0, boundingBox[1]);
-        int xMax = std::min(m_wide - 1, boundingBox[2]);
-        int yMax = std::min(m_height - 1, boundingBox[3]);
-
-        Fragment frag; // 是否进入三角形的标志
-        bool flag = false;
-        VectorI3D cy = triEdge.getResult(xMin, yMin); // 得到(xMin,yMin)即包围盒左上方顶点的对于三角形的边缘方程初始值
-
-        #pragma omp parallel for default(none)\shared(tri, triEdge, xMin, xMax, yMin, yMax, m_frameBuffer, m_shader, m_antiAliasing) \ private(y) \ firstprivate(triEdge)
-        for(int y = yMin; y <= yMax; y++) // 向屏幕下方开始遍历
-        {
-            flag = false;
-            VectorI3D cx = cy;
-            for(int x = xMin; x <= xMax; x++){
-                if(judgeInsideTriangle(triEdge, cx)) // 判断遍历的点是否在三角形内
-                {
-                    flag = true; // 进入三角形后置 1
-                    Vector3D bartcenTri = triEdge.getBarycentric(cx); // 得到该点的重心坐标用于插值
-                    float screenDepth = calculateInterpolation<float>(tri[0].screenDepth,
-                                                                      tri[1].screenDepth,
-                                                                      tri[2].screenDepth,
-                                                                      bartcenTri); // 对深度进行插值
-
-                    if(m_frameBuffer.judgeDepth(x, y, screenDepth)) // 对该点进行深度测试，若成功更新深度则绘制该点
-                    {
-                        // 先计算深度插值
-                        float viewDepth = 1.f / (bartcenTri.x / tri[0].ndcSpacePos.w + bartcenTri.y / tri[1].ndcSpacePos.w + bartcenTri.z / tri[2].ndcSpacePos.w);
-                        frag = constructFragment(x, y, screenDepth, viewDepth, tri, bartcenTri); // 构造着色点
-                        m_shader->fragmentShader(frag); // 应用片着色
-                         m_frameBuffer.setPixel(frag.screenPos.x, frag.screenPos.y, frag.fragmentColor);
-                    }
-                }
-                else if(flag){
-                    break; // 离开三角形，换行
-                }
-                triEdge.upX(cx); // X自增，边缘方程自增一定值
-            }
-            triEdge.upY(cy);  // Y自增，边缘方程自增一定值
-        }
-=======
     // SIMD分支
-    if(m_simd){rasterizationTriangleSimd(tri); return;}
+    if(m_simd){rasterizationTriangleSimd(tri, region, visibilityId); return;}
 
     CoordI4D boundingBox = getBoundingBox(tri); // 求三角形的包围盒
-    int xMin = std::max(0, boundingBox[0]);
-    int yMin = std::max(0, boundingBox[1]);
-    int xMax = std::min(m_wide - 1, boundingBox[2]);
-    int yMax = std::min(m_height - 1, boundingBox[3]);
+    int xMin = std::max(region[0], boundingBox[0]);
+    int yMin = std::max(region[1], boundingBox[1]);
+    int xMax = std::min(region[2], boundingBox[2]);
+    int yMax = std::min(region[3], boundingBox[3]);
 
     Fragment frag;
+    const TexCoordGradient texGradient = getTexCoordGradient(tri); // 纹理坐标导数用于选择 mip 层级
+    unsigned long long tested = 0, inside = 0, depthPassed = 0; // 本三角形的统计，结束后一次性累加
     bool flag = false;// 是否进入三角形的标志
     VectorI3D cy = triEdge.getResult(xMin, yMin); // 得到(xMin,yMin)即包围盒左上方顶点的对于三角形的边缘方程初始值
     for(int y = yMin; y <= yMax; y++) // 向屏幕下方开始遍历
@@ -481,22 +1015,32 @@ void SRendererDevice::rasterizationTriangle(Triangle& tri) // 光栅化三角形
         flag = false;
         VectorI3D cx = cy;
         for(int x = xMin; x <= xMax; x++){
+            tested++;
             // 判断遍历的点是否在三角形内
             if(judgeInsideTriangle(triEdge, cx)){
                 flag = true; // 进入三角形后置 1
+                inside++;
                 Vector3D bartcenTri = triEdge.getBarycentric(cx); // 得到该点的重心坐标用于插值
                 float screenDepth = calculateInterpolation<float>(tri[0].screenDepth, tri[1].screenDepth, tri[2].screenDepth, bartcenTri); // 对深度进行插值
                 if(m_frameBuffer.judgeDepth(x, y, screenDepth)) // 对该点进行深度测试，若成功更新深度则绘制该点
                 {
-                    float bartcen1 = bartcenTri.x / tri[0].ndcSpacePos.w;
-                    float bartcen2 = bartcenTri.y / tri[1].ndcSpacePos.w;
-                    float bartcen3 = bartcenTri.z / tri[2].ndcSpacePos.w;
-                    float bartcen = bartcen1 + bartcen2 + bartcen3;
-
-                    float viewDepth = 1.f / bartcen;// 计算深度插值
-                    frag = constructFragment(x, y, screenDepth, viewDepth, tri, bartcenTri); // 构造着色点
-                    m_shader->fragmentShader(frag); // 应用片着色
-                    m_frameBuffer.setPixel(frag.screenPos.x, frag.screenPos.y, frag.fragmentColor);
+                    depthPassed++;
+                    if(visibilityId != VISIBILITY_EMPTY){ // 可见性缓冲只记录三角形 ID，着色推迟到 resolveFrame()
+                        m_frameBuffer.setVisibility(x, y, visibilityId);
+                    }
+                    else{
+                        PipelineStageTimer timer(stats, &PipelineStatistics::shadeMs);
+                        float bartcen1 = bartcenTri.x / tri[0].ndcSpacePos.w;
+                        float bartcen2 = bartcenTri.y / tri[1].ndcSpacePos.w;
+                        float bartcen3 = bartcenTri.z / tri[2].ndcSpacePos.w;
+                        float bartcen = bartcen1 + bartcen2 + bartcen3;
+
+                        float viewDepth = 1.f / bartcen;// 计算深度插值
+                        frag = constructFragment(x, y, screenDepth, viewDepth, tri, bartcenTri); // 构造着色点
+                        setTexCoordDerivatives(frag, texGradient, viewDepth);
+                        m_shader->fragmentShader(frag); // 应用片着色
+                        m_frameBuffer.setPixel(frag.screenPos.x, frag.screenPos.y, frag.fragmentColor);
+                    }
                 }
             }
             else if(flag){
@@ -505,7 +1049,14 @@ void SRendererDevice::rasterizationTriangle(Triangle& tri) // 光栅化三角形
             triEdge.upX(cx); // X自增，边缘方程自增一定值
         }
         triEdge.upY(cy);  // Y自增，边缘方程自增一定值
->>>>>>> future
+    }
+    if(stats){
+        stats->pixelsTested += tested;
+        stats->fragmentsInside += inside;
+        stats->fragmentsDepthPassed += depthPassed;
+        if(visibilityId == VISIBILITY_EMPTY){
+            stats->fragmentsShaded += depthPassed;
+        }
     }
 }
 
@@ -615,13 +1166,13 @@ void SRendererDevice::executePerspectiveDivision(Triangle& tri) //透视除法
 
 }
 
-CoordI4D SRendererDevice::getBoundingBox(Triangle& tri) // 求三角形包围盒
+CoordI4D SRendererDevice::getBoundingBox(Triangle& tri) // 求三角形包围盒(已限制在屏幕内，完全在屏幕外时 min > max)
 {
-    int xMin = m_wide - 1;
-    int yMin = m_height - 1;
-    int xMax = 0;
-    int yMax = 0;
-    for(int i = 0; i < 3; i++)
+    int xMin = tri[0].screenPos.x;
+    int yMin = tri[0].screenPos.y;
+    int xMax = tri[0].screenPos.x;
+    int yMax = tri[0].screenPos.y;
+    for(int i = 1; i < 3; i++)
     {
         xMin = std::min(xMin, tri[i].screenPos.x);
         yMin = std::min(yMin, tri[i].screenPos.y);
@@ -630,10 +1181,10 @@ CoordI4D SRendererDevice::getBoundingBox(Triangle& tri) // 求三角形包围盒
     }
     return
     {
-        xMin > 0 ? xMin : 0,
-        yMin > 0 ? yMin : 0,
-        xMax > m_wide - 1 ? xMax : m_wide - 1,
-        yMax > m_height - 1 ? yMax : m_height -1
+        std::max(xMin, 0),
+        std::max(yMin, 0),
+        std::min(xMax, m_wide - 1),
+        std::min(yMax, m_height - 1)
     };
 }
 
@@ -651,6 +1202,9 @@ std::vector<Triangle> SRendererDevice::clipTriangle(Triangle& tri) // 剪裁三
     }
     // 如果全不在视体内，则返回一个空三角形(不渲染)
     if ((code[0] & code[1] & code[2]).any()){
+        if(t_pipelineStats){
+            t_pipelineStats->trianglesRejected++;
+        }
         return {};
     }
     if (((code[0] ^ code[1])[0]) || ((code[1] ^ code[2])[0]) || ((code[2] ^ code[0])[0])) // intersects near plane
@@ -681,7 +1235,11 @@ std::vector<Triangle> SRendererDevice::clipTriangle(Triangle& tri) // 剪裁三
                 res.push_back(tri[k]);
             }
         }
-        return constructTriangle(res);
+        std::vector<Triangle> clipped = constructTriangle(res);
+        if(t_pipelineStats){
+            t_pipelineStats->trianglesClipped += clipped.size();
+        }
+        return clipped;
     }
     return std::vector<Triangle>{tri};
 }
@@ -725,49 +1283,57 @@ std::optional<Line> SRendererDevice::clipLine(Line& line) // 剪裁线框
     return line;
 }
 
-void SRendererDevice::rasterizationTriangleSimd(Triangle& tri)
+void SRendererDevice::rasterizationTriangleSimd(Triangle& tri, const CoordI4D& region, uint64_t visibilityId)
 {
     EdgeEquationSimd triEdgeSimd(tri);
 
     CoordI4D boundingBox = getBoundingBox(tri); // 求三角形的包围盒
-    int xMin = std::max(0, boundingBox[0]);
-    int yMin = std::max(0, boundingBox[1]);
-    int xMax = std::min(m_wide - 1, boundingBox[2]);
-    int yMax = std::min(m_height - 1, boundingBox[3]);
+    int xMin = std::max(region[0], boundingBox[0]);
+    int yMin = std::max(region[1], boundingBox[1]);
+    int xMax = std::min(region[2], boundingBox[2]);
+    int yMax = std::min(region[3], boundingBox[3]);
 
+    PipelineStatistics* stats = t_pipelineStats;
+    if(xMin > xMax || yMin > yMax){
+        return;
+    }
+
+    // Hi-Z 三角形级剔除：三角形最近的深度也不比包围盒内任何块的最大深度更近时整体跳过
+    const float triMinDepth = std::min({tri[0].screenDepth, tri[1].screenDepth, tri[2].screenDepth});
+    if(m_frameBuffer.judgeHiZOccluded({xMin, yMin, xMax, yMax}, triMinDepth - HIZ_DEPTH_EPSILON)){
+        if(stats){
+            stats->trianglesHiZRejected++;
+        }
+        return;
+    }
+    // 深度在屏幕空间是线性的：z(x, y) = dzdx * x + dzdy * y + dzc，与重心坐标插值使用同一组边缘方程系数
+    const double z0 = tri[0].screenDepth, z1 = tri[1].screenDepth, z2 = tri[2].screenDepth;
+    const double delta = 1.0 / triEdgeSimd.m_twoArea;
+    const double dzdx = delta * (z0 * (tri[1].screenPos.y - tri[2].screenPos.y) + z1 * (tri[2].screenPos.y - tri[0].screenPos.y) + z2 * (tri[0].screenPos.y - tri[1].screenPos.y));
+    const double dzdy = delta * (z0 * (tri[2].screenPos.x - tri[1].screenPos.x) + z1 * (tri[0].screenPos.x - tri[2].screenPos.x) + z2 * (tri[1].screenPos.x - tri[0].screenPos.x));
+    const double dzc = z0 - dzdx * tri[0].screenPos.x - dzdy * tri[0].screenPos.y;
+    const TexCoordGradient texGradient = getTexCoordGradient(tri); // 纹理坐标导数用于选择 mip 层级
+
+    unsigned long long tested = 0, inside = 0, depthPassed = 0, shaded = 0, hiZRejected = 0; // 本三角形的统计，结束后一次性累加
+    int dirtyBlockMin = INT_MAX, dirtyBlockMax = -1; // 当前 8 行中写过深度的 Hi-Z 块范围
     // 在x坐标以8个像素为单位遍历包围盒
     for(int y = yMin; y <= yMax; ++y)
     {
-<<<<<<< HEAD
-        __m256i y_simd = _mm256_set1_epi32(y);// 初始化8个像素的y坐标SIMD向量 (都是当前行的y)
-        for(int x_start = xMin; x_start <= xMax; x_start += 8)
-        {
-            // 生成8个像素的x坐标SIMD向量
-            __m256i x_simd = _mm256_setr_epi32(x_start, x_start + 1, x_start + 2, x_start + 3, x_start + 4, x_start + 5, x_start + 6, x_start + 7);
-
-            // 1. 计算8个像素的边缘方程值
-            SimdVectorI3D edge_values_simd = triEdgeSimd.getResultSimd(x_simd, y_simd);
-
-            // 2. 判断8个像素是否在三角形内部
-            __m256i inside_mask_simd = triEdgeSimd.judgeInsideTriangleSimd(edge_values_simd);
-
-            // 处理包围盒右边界：创建一个掩码，只包含在 [xMin, xMax] 范围内的像素
-            __m256i x_coords_simd = _mm256_add_epi32(_mm256_set1_epi32(x_start), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
-            __m256i x_in_bounds_mask = _mm256_and_si256(
-                _mm256_cmpgt_epi32(x_coords_simd, _mm256_set1_epi32(xMin - 1)), // x >= xMin
-                _mm256_cmpgt_epi32(_mm256_set1_epi32(xMax + 1), x_coords_simd)  // x <= xMax
-                );
-            // 最终的内部掩码还需要与包围盒边界掩码求与
-            inside_mask_simd = _mm256_and_si256(inside_mask_simd, x_in_bounds_mask);
-            // 将整型掩码转换为浮点型掩码
-            __m256 inside_mask_ps = _mm256_castsi256_ps(inside_mask_simd);
-
-            int inside_mask_int = _mm256_movemask_ps(inside_mask_ps);
-            if (inside_mask_int == 0) {
-=======
         __m256i simdY = _mm256_set1_epi32(y);// 初始化8个像素的y坐标SIMD向量 (都是当前行的y)
+        const int blockY = y / HIZ_BLOCK_SIZE;
+        const double rowDepth = dzdy * y + dzc;
         for(int xStart = xMin; xStart <= xMax; xStart += 8)
         {
+            // 0. Hi-Z 块级剔除：这 8 个像素(最多跨两个块)上三角形深度的下界不比块的最大深度更近，则不可能通过深度测试
+            const int blockX0 = xStart / HIZ_BLOCK_SIZE;
+            const int blockX1 = std::min(xStart + 7, xMax) / HIZ_BLOCK_SIZE;
+            const float hiZ0 = m_frameBuffer.getHiZ(blockX0, blockY);
+            const float hiZ1 = m_frameBuffer.getHiZ(blockX1, blockY);
+            float spanMinDepth = static_cast<float>(rowDepth + std::min(dzdx * xStart, dzdx * (xStart + 7)));
+            if(std::max(spanMinDepth, triMinDepth) - HIZ_DEPTH_EPSILON >= std::max(hiZ0, hiZ1)){
+                hiZRejected += std::min(xMax, xStart + 7) - std::max(xMin, xStart) + 1;
+                continue;
+            }
             // 生成8个像素的x坐标SIMD向量
             __m256i simdX = _mm256_setr_epi32(xStart, xStart + 1, xStart + 2, xStart + 3, xStart + 4, xStart + 5, xStart + 6, xStart + 7);
 
@@ -789,37 +1355,14 @@ void SRendererDevice::rasterizationTriangleSimd(Triangle& tri)
             __m256 insideMask = _mm256_castsi256_ps(simdInsideMask);
 
             int insideMaskInt =  _mm256_movemask_ps(insideMask);
+            tested += __builtin_popcount(_mm256_movemask_ps(_mm256_castsi256_ps(xInBoundsMask)));
+            inside += __builtin_popcount(insideMaskInt);
             if (insideMaskInt == 0) {
->>>>>>> future
                 // 如果这个8像素块没有任何像素在三角形内部（且符合规则和边界），直接跳过后续处理
                 continue;
             }
 
             // 3. 计算通过内部测试的像素的重心坐标
-<<<<<<< HEAD
-            SimdVector3D barycentric_simd = triEdgeSimd.getBarycentricSimd(edge_values_simd);
-
-            // 4. SIMD 属性插值 (仅对通过内部测试的像素进行有效插值)
-            // 使用 blend 指令根据 inside_mask_ps 屏蔽插值结果
-            // 无效像素的插值结果将设置为一个可以被后续处理忽略的值
-            __m256 screenDepth_simd_interp = calculateInterpolationSimdFloat(tri[0].screenDepth, tri[1].screenDepth, tri[2].screenDepth, barycentric_simd);
-
-            //构造片元
-            SimdFragment fragment_simd = constructFragmentSimd(x_simd, y_simd, screenDepth_simd_interp, barycentric_simd, tri);
-
-            // 5. SIMD 深度测试
-            __m256 depth_test_mask_ps = m_frameBuffer.judgeDepthSimd(inside_mask_ps, fragment_simd.screenPosX, fragment_simd.screenPosY, fragment_simd.screenDepth);
-
-            // 6. 合并掩码：只有同时在三角形内部且通过深度测试的像素才会被绘制
-            __m256 final_mask_ps = _mm256_and_ps(inside_mask_ps, depth_test_mask_ps);
-
-            // 检查是否有任何像素通过了所有测试
-            int mask_int = _mm256_movemask_ps(final_mask_ps);
-            if(mask_int != 0){
-                // === Fallback 到非 SIMD 片元着色和像素写入 ===
-                // ** 提取所有 SIMD 向量数据到数组 **
-                int screenPosX_arr[8], screenPosY_arr[8];
-=======
             SimdVector3D simdBarycentric = triEdgeSimd.getBarycentricSimd(simdeEdgeVal);
 
             // 4. SIMD 属性插值 (仅对通过内部测试的像素进行有效插值)
@@ -827,11 +1370,9 @@ void SRendererDevice::rasterizationTriangleSimd(Triangle& tri)
             // 无效像素的插值结果将设置为一个可以被后续处理忽略的值
             __m256 simdScreenDepthInterp =  calculateInterpolationSimdFloat(tri[0].screenDepth, tri[1].screenDepth, tri[2].screenDepth, simdBarycentric);
 
-            //构造片元
-            SimdFragment simdFragment = constructFragmentSimd(simdX, simdY, simdScreenDepthInterp, simdBarycentric, tri);
-
             // 5. SIMD 深度测试
-            __m256 depthTestMask = m_frameBuffer.judgeDepthSimd(insideMask, simdFragment.screenPosX, simdFragment.screenPosY, simdFragment.screenDepth);
+            __m256 previousDepth;
+            __m256 depthTestMask = m_frameBuffer.judgeDepthSimd(insideMask, xStart, y, simdScreenDepthInterp, &previousDepth);
 
             // 6. 合并掩码：只有同时在三角形内部且通过深度测试的像素才会被绘制
             __m256 finalMask = _mm256_and_ps(insideMask, depthTestMask);
@@ -839,52 +1380,38 @@ void SRendererDevice::rasterizationTriangleSimd(Triangle& tri)
             // 检查是否有任何像素通过了所有测试
             int maskInt = _mm256_movemask_ps(finalMask);
             if(maskInt != 0){
-                // m_shader->fragmentShaderSIMD(simdFragment, finalMask);
-                // m_frameBuffer.setPixelSIMD(simdX, simdY, simdFragment.fragmentColor, finalMask);
+                depthPassed += __builtin_popcount(maskInt);
+                // 只有覆盖了块内最大深度的像素时，块的最大深度才可能变小，需要重新计算
+                __m256 coversMax = _mm256_cmp_ps(previousDepth, _mm256_set1_ps(std::min(hiZ0, hiZ1)), _CMP_GE_OQ);
+                if(_mm256_movemask_ps(_mm256_and_ps(coversMax, finalMask)) != 0){
+                    dirtyBlockMin = std::min(dirtyBlockMin, blockX0);
+                    dirtyBlockMax = std::max(dirtyBlockMax, blockX1);
+                }
+                if(visibilityId != VISIBILITY_EMPTY){ // 可见性缓冲只记录三角形 ID，着色推迟到 resolveFrame()
+                    m_frameBuffer.setVisibilitySimd(xStart, y, visibilityId, finalMask);
+                    continue;
+                }
+                PipelineStageTimer timer(stats, &PipelineStatistics::shadeMs);
+                //构造片元(只为通过深度测试的像素组构造)
+                SimdFragment simdFragment = constructFragmentSimd(simdX, simdY, simdScreenDepthInterp, simdBarycentric, tri);
+                if(m_simdShading){
+                    correctPerspectiveSimd(simdFragment);
+                    setTexCoordDerivativesSimd(simdFragment, texGradient);
+                    m_shader->fragmentShaderSIMD(simdFragment, finalMask);
+                    m_frameBuffer.setPixelSIMD(simdX, simdY, simdFragment.fragmentColor, finalMask);
+                    shaded += __builtin_popcount(maskInt);
+                    continue;
+                }
 
                 // === Fallback 到非 SIMD 片元着色和像素写入 ===
                 //  提取所有 SIMD 向量数据到数组
                 int screenPosXArr[8], screenPosYArr[8];
->>>>>>> future
                 float screenDepth_arr[8];
                 float w_reciprocal_arr[8];
                 float texCoord_div_w_x_arr[8], texCoord_div_w_y_arr[8], texCoord_div_w_z_arr[8];
                 float normal_div_w_x_arr[8], normal_div_w_y_arr[8], normal_div_w_z_arr[8];
                 float worldSpacePos_div_w_x_arr[8], worldSpacePos_div_w_y_arr[8], worldSpacePos_div_w_z_arr[8];
                 // ** 替换 _mm256_storeu_epi32 的部分：手动提取整型元素 **
-<<<<<<< HEAD
-                __m128i screenPosX_low = _mm256_extractf128_si256(fragment_simd.screenPosX, 0); // 提取低 128 位 (前4个元素)
-                __m128i screenPosX_high = _mm256_extractf128_si256(fragment_simd.screenPosX, 1); // 提取高 128 位 (后4个元素)
-                __m128i screenPosY_low = _mm256_extractf128_si256(fragment_simd.screenPosY, 0); // 提取低 128 位
-                __m128i screenPosY_high = _mm256_extractf128_si256(fragment_simd.screenPosY, 1); // 提取高 128 位
-                for(int i = 0; i < 4; ++i) {
-                    screenPosX_arr[i] = _mm_extract_epi32(screenPosX_low, i); // 从 128 位向量中提取 32 位整数
-                    screenPosY_arr[i] = _mm_extract_epi32(screenPosY_low, i);
-                }
-                for(int i = 0; i < 4; ++i) {
-                    screenPosX_arr[i + 4] = _mm_extract_epi32(screenPosX_high, i); // 从 128 位向量中提取 32 位整数
-                    screenPosY_arr[i + 4] = _mm_extract_epi32(screenPosY_high, i);
-                }
-                // ** 替换结束 **
-                // ** 使用 _mm256_storeu_ps 提取浮点数据 ** (这部分没有报错，保留)
-                _mm256_storeu_ps(screenDepth_arr, fragment_simd.screenDepth);
-                _mm256_storeu_ps(w_reciprocal_arr, fragment_simd.viewDepth);
-                _mm256_storeu_ps(texCoord_div_w_x_arr, fragment_simd.texCoord.x);
-                _mm256_storeu_ps(texCoord_div_w_y_arr, fragment_simd.texCoord.y);
-                _mm256_storeu_ps(texCoord_div_w_z_arr, fragment_simd.texCoord.z);
-                _mm256_storeu_ps(normal_div_w_x_arr, fragment_simd.normal.x);
-                _mm256_storeu_ps(normal_div_w_y_arr, fragment_simd.normal.y);
-                _mm256_storeu_ps(normal_div_w_z_arr, fragment_simd.normal.z);
-                _mm256_storeu_ps(worldSpacePos_div_w_x_arr, fragment_simd.worldSpacePos.x);
-                _mm256_storeu_ps(worldSpacePos_div_w_y_arr, fragment_simd.worldSpacePos.y);
-                _mm256_storeu_ps(worldSpacePos_div_w_z_arr, fragment_simd.worldSpacePos.z);
-
-                for (int i = 0; i < 8; ++i) {
-                    if ((mask_int >> i) & 1) // 如果第i个像素通过所有测试
-                    {
-                        int current_x = screenPosX_arr[i];
-                        int current_y = screenPosY_arr[i];
-=======
                 __m128i screenPosX_low = _mm256_extractf128_si256(simdFragment.screenPosX, 0); // 提取低 128 位 (前4个元素)
                 __m128i screenPosX_high = _mm256_extractf128_si256(simdFragment.screenPosX, 1); // 提取高 128 位 (后4个元素)
                 __m128i screenPosY_low = _mm256_extractf128_si256(simdFragment.screenPosY, 0); // 提取低 128 位
@@ -915,7 +1442,6 @@ void SRendererDevice::rasterizationTriangleSimd(Triangle& tri)
                     {
                         int current_x = screenPosXArr[i];
                         int current_y = screenPosYArr[i];
->>>>>>> future
                         Fragment single_frag;
                         single_frag.screenPos = { current_x, current_y };
                         single_frag.screenDepth = screenDepth_arr[i];
@@ -923,21 +1449,33 @@ void SRendererDevice::rasterizationTriangleSimd(Triangle& tri)
                         float w_recip = w_reciprocal_arr[i]; // 插值后的 1/w
                         // 防止除以零
                         if (w_recip == 0.0f) continue;
+                        shaded++;
                         single_frag.texCoord = { texCoord_div_w_x_arr[i] / w_recip, texCoord_div_w_y_arr[i] / w_recip }; // Assuming Coord2D has 2 components
                         single_frag.normal = { normal_div_w_x_arr[i] / w_recip, normal_div_w_y_arr[i] / w_recip, normal_div_w_z_arr[i] / w_recip };
                         single_frag.worldSpacePos = { worldSpacePos_div_w_x_arr[i] / w_recip, worldSpacePos_div_w_y_arr[i] / w_recip, worldSpacePos_div_w_z_arr[i] / w_recip };
+                        setTexCoordDerivatives(single_frag, texGradient, 1.f / w_recip);
                         // 调用非 SIMD 片元着色器
                         m_shader->fragmentShader(single_frag);
                         // 逐个设置像素
                         m_frameBuffer.setPixel(single_frag.screenPos.x, single_frag.screenPos.y, single_frag.fragmentColor);
-<<<<<<< HEAD
-=======
 
->>>>>>> future
                     }
                 }
             }
         }
+        // 一个块的 8 行处理完(或到达包围盒底部)后，重新计算写过深度的块的最大深度
+        if((y % HIZ_BLOCK_SIZE == HIZ_BLOCK_SIZE - 1 || y == yMax) && dirtyBlockMin <= dirtyBlockMax){
+            m_frameBuffer.updateHiZ(dirtyBlockMin, dirtyBlockMax, blockY);
+            dirtyBlockMin = INT_MAX;
+            dirtyBlockMax = -1;
+        }
+    }
+    if(stats){
+        stats->pixelsTested += tested;
+        stats->fragmentsInside += inside;
+        stats->fragmentsDepthPassed += depthPassed;
+        stats->fragmentsShaded += shaded;
+        stats->pixelsHiZRejected += hiZRejected;
     }
 }
 
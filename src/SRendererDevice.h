@@ -7,23 +7,19 @@
 #include <future>
 #include <atomic>
 #include <optional>
+#include <functional>
 #include <immintrin.h>
-<<<<<<< HEAD
-=======
 #include "tbb/parallel_for.h"
 #include "tbb/blocked_range3d.h"
 #include "tbb/parallel_for_each.h"
->>>>>>> future
+#include "tbb/enumerable_thread_specific.h"
+#include "tbb/task_arena.h"
 #include "Shader.h"
 #include "Texture.h"
-#include "threadpool.h"
+#include "TaskScheduler.h"
 #include "SRFrameBuffer.h"
 #include "BasicDataStructure.h"
 
-<<<<<<< HEAD
-
-=======
->>>>>>> future
 struct EdgeEquation //三角形(中某点)对应的边缘方程
 {
     VectorI3D m_i; // x方向上每移动一个单位距离，边界函数的增量
@@ -58,21 +54,66 @@ struct EdgeEquationSimd
     __m256i judgeInsideTriangleSimd(const SimdVectorI3D& edge_values_simd);
 };
 
-class Shader;
+// 管线统计(类似 GL 的 pipeline statistics query)，各线程独立计数，render() 结束时合并
+struct PipelineStatistics
+{
+    unsigned long long meshesSubmitted{0};      // 提交绘制的网格
+    unsigned long long meshesCulled{0};         // 包围体整体位于视锥外、未进入管线的网格
+    unsigned long long meshletsSubmitted{0};
+    unsigned long long meshletsFrustumCulled{0};  // 包围球位于视锥外
+    unsigned long long meshletsBackfaceCulled{0}; // 法线锥判定全部三角形背向相机
+    unsigned long long verticesShaded{0};       // 执行顶点着色的顶点
+    unsigned long long trianglesSubmitted{0};   // 提交的三角形
+    unsigned long long trianglesRejected{0};    // 被 clipTriangle 整体剔除
+    unsigned long long trianglesClipped{0};     // 与近平面相交、裁剪后新生成的三角形
+    unsigned long long trianglesCulled{0};      // 背面或零面积剔除(m_twoArea <= 0)
+    unsigned long long pixelsTested{0};         // 包围盒内参与边缘测试的像素
+    unsigned long long fragmentsInside{0};      // 位于三角形内部的片元
+    unsigned long long fragmentsDepthPassed{0}; // 通过深度测试的片元
+    unsigned long long fragmentsShaded{0};      // 执行片元着色的片元
+    unsigned long long trianglesHiZRejected{0}; // 被 Hi-Z 整体剔除的三角形(仅 SIMD 路径)
+    unsigned long long pixelsHiZRejected{0};    // 被 Hi-Z 块级剔除、未做边缘测试的像素
+    // 各阶段耗时(毫秒，为各线程时间之和)；rasterMs 不含 shadeMs
+    double vertexMs{0.0};
+    double clipMs{0.0};
+    double rasterMs{0.0};
+    double shadeMs{0.0};
+    double renderMs{0.0}; // render() 的墙钟时间
+
+    void merge(const PipelineStatistics& other);
+};
 
-<<<<<<< HEAD
+static constexpr int TILE_SIZE = 64; // 分块光栅化时屏幕 tile 的边长(像素)
+static constexpr int VERTEX_BLOCK_SIZE = 1024; // 顶点着色时每个并行任务处理的顶点数
+static constexpr float HIZ_DEPTH_EPSILON = 1e-5f; // Hi-Z 比较留出的余量，吸收平面求值与重心插值之间的舍入误差
+static_assert(TILE_SIZE % HIZ_BLOCK_SIZE == 0, "a Hi-Z block must not straddle two tiles");
+// 可见性缓冲 ID：高 32 位为本帧的绘制序号，低 32 位为前端分块号(高 8 位)与分块内三角形下标(低 24 位)
+static constexpr int VISIBILITY_CHUNK_SHIFT = 24;
+static constexpr int MAX_VISIBILITY_CHUNKS = 1 << (32 - VISIBILITY_CHUNK_SHIFT);
 
-class SRendererDevice
+using BufferHandle = int; // 设备资源表中的下标
+static constexpr BufferHandle INVALID_BUFFER = -1;
+
+struct ResourceSlots // 资源表的分配状态：已释放的句柄留待复用，重复释放同一句柄时忽略
 {
-public:
-    RendererMode m_rendererMode;
-    bool m_faceCulling; // 面剔除
-    bool m_multiThread; // 多线程加速
-    bool m_simd;
-    std::vector<Vertex> m_vertexList; // 存储模型顶点
-    std::vector<unsigned> m_indices;  // 存储模型顶点的绘制顺序
-    std::vector<Texture> m_textureList; // 存储每一帧图片
-=======
+    std::vector<BufferHandle> freeList;
+    std::vector<uint8_t> live; // 与资源表等长，1 表示句柄正在使用
+};
+
+struct VertexBuffer // 设备持有的顶点资源，创建时一并生成 SIMD 顶点着色使用的 SoA 输入流
+{
+    std::vector<Vertex> vertices;
+    VertexStream stream;
+};
+
+struct VisibilityDraw // 可见性缓冲模式下保留到帧末着色的一次绘制
+{
+    std::vector<std::vector<Triangle>> triangles; // 该绘制各前端分块输出的屏幕空间三角形
+    Material material; // 绘制时着色器使用的材质
+};
+
+class Shader;
+
 class SRendererDevice
 {
 public:
@@ -82,11 +123,17 @@ public:
     bool m_multiThread;
     bool m_tbbThread;
     bool m_simd;
+    bool m_simdShading; // SIMD 光栅化时使用 SIMD 片元着色与写入，关闭时逐像素回退到标量着色
     bool m_useFXAA;
-    std::vector<Vertex> m_vertexList; // 存储模型顶点
-    std::vector<unsigned> m_indices;  // 存储模型顶点的绘制顺序
-    std::vector<Texture> m_textureList; // 存储每
->>>>>>> future
+    int m_threadCount; // 工作窃取调度器的线程数(含调用线程)，<= 0 时为 hardware_concurrency
+    bool m_pipelineStats; // 是否统计管线数据(开启后有额外计时开销)
+    bool m_tileBinning; // 分块(sort-middle)光栅化：三角形先按屏幕 tile 分箱，每个 tile 只由一个线程光栅化
+    bool m_visibilityBuffer; // 可见性缓冲：光栅化只写深度与三角形 ID，resolveFrame() 对每个可见像素只着色一次(总是分块光栅化)
+    TextureFilter m_textureFilter; // 纹理过滤方式，默认三线性(mip 层级由纹理坐标的屏幕空间导数选择)
+    TextureLayout m_textureLayout; // 加载纹理时使用的纹素布局，只影响之后加载的模型
+    bool m_frustumCulling; // 绘制网格前用其包围体与视锥做整体剔除
+    bool m_meshletCulling; // 绘制网格前逐 meshlet 做视锥与法线锥剔除，只对剩余三角形引用的顶点做顶点着色
+    std::vector<Texture> m_textureList; // 纹理资源表，下标即 createTexture() 返回的句柄，材质直接按下标引用
     std::unique_ptr<Shader> m_shader;  // 着色方式
     Color m_clearColor;
     Color m_pointColor;
@@ -95,15 +142,31 @@ public:
     SRendererDevice(int wide, int height);
     ~SRendererDevice();
     void clearBuffer();
-    QImage& getBuffer();
+    QImage& getBuffer(); // 当前渲染目标
+    QImage& getPresentImage(); // 显示线程调用：最近一次 presentFrame() 提交的帧
     bool saveImage(QString path);
     void render();
+    // 资源在首次使用前创建一次，之后的绘制只按句柄引用，不再拷贝顶点、索引与纹理。
+    // 数据按值传入，调用方移动传入时不产生拷贝；释放后句柄可能被之后创建的资源复用，重复释放或释放无效句柄时什么也不做
+    BufferHandle createVertexBuffer(std::vector<Vertex> vertices);
+    BufferHandle createIndexBuffer(std::vector<unsigned> indices);
+    BufferHandle createTexture(Texture texture);
+    void releaseVertexBuffer(BufferHandle handle);
+    void releaseIndexBuffer(BufferHandle handle);
+    void releaseTexture(BufferHandle handle);
+    void bindVertexBuffer(BufferHandle handle); // 之后的 cullMeshlets()/render() 使用的顶点缓冲
+    // 用当前着色器的 MVP 矩阵把视景体平面变换到模型空间，测试网格的包围球与 AABB；关闭视锥剔除时总是返回 true
+    bool isMeshVisible(const Coord3D& aabbMin, const Coord3D& aabbMax, const Coord3D& centre, float radius);
+    // 选出本次绘制的索引：未被剔除的 meshlet 的索引拷贝到内部缓冲，并标记需要顶点着色的顶点；全部被剔除时返回 false。
+    // meshlets 为空或关闭 meshlet 剔除时直接引用索引缓冲，不做拷贝
+    bool cullMeshlets(const std::vector<Meshlet>& meshlets, BufferHandle indexBuffer);
+    void resolveFrame(); // 一帧的所有绘制结束后调用：可见性缓冲模式下执行着色，其他模式下什么也不做
+    void presentFrame(); // resolveFrame() 之后调用：帧缓冲为三缓冲时把完成的一帧交给显示端并换到下一个颜色缓冲
     static void init(int& wide, int& height);
     static SRendererDevice& getInstance(int wide = 0, int height = 0); // 获取简单的实例，用于外部调用
-<<<<<<< HEAD
-=======
     SRFrameBuffer& getFrameBuffer();
->>>>>>> future
+    const PipelineStatistics& getPipelineStatistics() const; // 自上次重置以来累计的管线统计
+    void resetPipelineStatistics();
 
     //ban
     SRendererDevice(const SRendererDevice&) = delete;
@@ -118,10 +181,45 @@ private:
     std::array<BorderPlane, 6> m_viewPlanes; //视景体(用于判定渲染范围和面剔除)
     std::array<BorderLine, 4> m_screenLines;
     SRFrameBuffer m_frameBuffer;
-    std::unique_ptr<ThreadPool> m_threadPool;
-
-    void processTriangle(Triangle& tri);  //处理三角形
-    void rasterizationTriangle(Triangle& tri); //光栅化三角形
+    std::unique_ptr<TaskScheduler> m_scheduler; // m_multiThread 时使用；线程数与 m_threadCount 不符时在下次并行执行前重建
+    int m_schedulerThreadCount; // 创建 m_scheduler 时的 m_threadCount，0 表示 hardware_concurrency
+    PipelineStatistics m_pipelineStatistics;
+    std::vector<PipelineStatistics> m_slotStatistics; // parallelExecute 按调度器队列序号分开计数，跨派发复用
+    std::vector<VertexBuffer> m_vertexBuffers; // 下标即句柄，释放后清空并记入空闲列表
+    std::vector<std::vector<unsigned>> m_indexBuffers;
+    ResourceSlots m_vertexBufferSlots;
+    ResourceSlots m_indexBufferSlots;
+    ResourceSlots m_textureSlots; // 只跟踪由 createTexture 创建的纹理，直接写入 m_textureList 的纹理不能释放
+    BufferHandle m_boundVertexBuffer;
+    const std::vector<unsigned>* m_drawIndices; // 本次绘制的索引，由 cullMeshlets 设置：指向索引缓冲或 m_culledIndices
+    std::vector<unsigned> m_culledIndices; // 未被剔除的 meshlet 的索引，跨绘制复用容量
+    std::vector<Vertex> m_transformedVertices; // 顶点着色后的缓冲，与绑定的顶点缓冲一一对应，图元装配按下标读取
+    std::vector<uint8_t> m_vertexGroupMask; // 由 cullMeshlets 设置，非空时只对标记的8顶点组做顶点着色；顶点着色后清空
+    int m_tileCountX; // 屏幕在 x 方向上的 tile 数量
+    int m_tileCountY;
+    std::vector<std::vector<Triangle>> m_binnedTriangles; // 每个前端分块输出的屏幕空间三角形
+    std::vector<std::vector<std::vector<unsigned>>> m_tileBins; // [前端分块][tile] -> m_binnedTriangles 中的下标
+    std::vector<VisibilityDraw> m_visibilityDraws; // 跨帧复用，只有前 m_visibilityDrawCount 个属于本帧
+    int m_visibilityDrawCount; // 本帧已光栅化、等待着色的绘制数，也是当前绘制的序号
+    std::vector<unsigned> m_resolvePixels;  // 着色时每个 tile 的可见像素，按绘制序号分组
+    std::vector<unsigned> m_resolveOffsets; // [tile][绘制] -> 该绘制在 m_resolvePixels 中的起始位置
+
+    std::array<BorderPlane, 6> getModelSpaceViewPlanes() const; // m_viewPlanes 变换到当前模型空间(未归一化)
+    int getWorkerCount() const; // 当前多线程设置下的并行数量
+    // 按当前多线程设置把 [0, count) 分成连续区间并行调用 body(区间起点, 区间终点)。
+    // 模板参数直接传给调度器，不经过 std::function，派发不分配内存，区间内的循环也不是间接调用
+    template<typename Body>
+    void parallelExecute(int count, Body&& body);
+    void processVertices(); // 对绑定的顶点缓冲中每个顶点只着色一次，写入 m_transformedVertices
+    void processVerticesSimd(int start, int end); // 从 SoA 输入流一次着色8个顶点
+    void renderTiled(int triangleCount); // 分块光栅化入口
+    void binTriangle(Triangle& tri, int chunk); // 将屏幕空间三角形分箱到其覆盖的 tile
+    void rasterizationTile(int tile); // 按提交顺序光栅化落在该 tile 内的三角形
+    void groupVisiblePixels(int tile); // 把 tile 内的可见像素按绘制序号做计数排序
+    void resolveTile(int tile, int draw); // 对 tile 内属于该绘制的可见像素重建片元并着色
+    void processTriangle(int index, int binChunk = -1);  //装配并处理第 index 个三角形，binChunk >= 0 时只做几何处理并分箱
+    void drawTriangle(Triangle& tri, int binChunk); //透视除法、屏幕映射后按渲染模式绘制(或分箱)
+    void rasterizationTriangle(Triangle& tri, const CoordI4D& region, uint64_t visibilityId = VISIBILITY_EMPTY); //光栅化三角形，只写入 region(xMin, yMin, xMax, yMax) 内的像素；给出 visibilityId 时只写深度与 ID
     void wireFrameTriangle(Triangle& tri); //绘制线框三角形
     void pointTriangle(Triangle& tri); //绘制点三角形
     void drawLine(Line& line); //绘制线段
@@ -130,14 +228,10 @@ private:
     CoordI4D getBoundingBox(Triangle& tri); //算出三角形包围盒
     std::vector<Triangle> clipTriangle(Triangle& tri); // 剪裁三角形
     std::optional<Line> clipLine(Line& line); //剪裁线
-<<<<<<< HEAD
-    // Color antiAliasing(CoordI2D &coord);
-=======
     void extractFragmentData();
->>>>>>> future
 
     //SIMD
-    void rasterizationTriangleSimd(Triangle& tri);
+    void rasterizationTriangleSimd(Triangle& tri, const CoordI4D& region, uint64_t visibilityId);
 };
 
 #endif // SRENDERERDEVICE_H
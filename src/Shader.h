@@ -1,10 +1,7 @@
 #ifndef SHADER_H
 #define SHADER_H
 
-<<<<<<< HEAD
-=======
 #include <QImage>
->>>>>>> future
 #include "SRendererDevice.h"
 #include "BasicDataStructure.h"
 
@@ -16,21 +13,24 @@ public:
     glm::mat4 m_modelTransformation; // 模型变换矩阵
     glm::mat4 m_viewTransformation;   // 视口变换矩阵
     glm::mat4 m_projectionTransformation; //投影变换矩阵
+    glm::mat3 m_normalTransformation; // 法线变换矩阵(模型矩阵逆的转置)，由 updateDrawTransformation 每次绘制计算一次
+    glm::mat4 m_viewProjectionTransformation; // 投影矩阵 * 视图矩阵
     std::vector<Light> m_lightList;
     Material m_material;
     Coord3D m_eyePos;
 
-<<<<<<< HEAD
-    virtual void vertexShader(Vertex& vertex) = 0;
-    virtual void fragmentShader(Fragment& fragment) = 0;
-    virtual void fragmentShaderSIMD(SimdFragment& frag_simd) = 0;
-=======
     virtual void FXAAShader(QImage& image, float edgeThresshold, float subpixBlendStrength, float lumaThresholdMin) = 0;
     virtual void simdFXAAShader(QImage& image, int wide, int height, float edgeThresshold) = 0;
     virtual void vertexShader(Vertex& vertex) = 0;
+    virtual void vertexShaderSIMD(SimdVertex& vertex_simd) = 0; // 一次变换8个顶点
     virtual void fragmentShader(Fragment& fragment) = 0;
     virtual void fragmentShaderSIMD(SimdFragment& frag_simd, __m256& final_mask) = 0;
->>>>>>> future
+
+    void updateDrawTransformation() // 绘制前计算由变换矩阵派生的矩阵，避免逐顶点重复计算
+    {
+        m_normalTransformation = glm::mat3(glm::transpose(glm::inverse(m_modelTransformation)));
+        m_viewProjectionTransformation = m_projectionTransformation * m_viewTransformation;
+    }
 };
 
 #endif // SHADER_H
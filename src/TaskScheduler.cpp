@@ -0,0 +1,220 @@
+#include "TaskScheduler.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+namespace {
+thread_local const TaskScheduler* t_scheduler = nullptr; // 当前线程所属的调度器(外部线程为空)
+thread_local int t_slot = -1;
+thread_local unsigned t_stealSeed = 0;
+
+unsigned nextRandom() // xorshift，用于选择窃取对象
+{
+    if(t_stealSeed == 0){
+        t_stealSeed = static_cast<unsigned>(std::hash<std::thread::id>()(std::this_thread::get_id())) | 1u;
+    }
+    t_stealSeed ^= t_stealSeed << 13;
+    t_stealSeed ^= t_stealSeed >> 17;
+    t_stealSeed ^= t_stealSeed << 5;
+    return t_stealSeed;
+}
+} // namespace
+
+TaskScheduler::TaskScheduler(int workerCount)
+    :m_slotCount(workerCount > 0 ? workerCount : std::max(1u, std::thread::hardware_concurrency()))
+    ,m_queues(m_slotCount)
+{
+    for(int i = 0; i < m_slotCount - 1; i++){
+        m_workers.emplace_back(&TaskScheduler::workerLoop, this, i);
+    }
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> locker(m_parkMutex);
+        m_stop = true;
+    }
+    m_parkCondition.notify_all();
+    for(auto& worker : m_workers){
+        worker.join();
+    }
+}
+
+int TaskScheduler::currentSlot() const
+{
+    return t_scheduler == this ? t_slot : m_slotCount - 1;
+}
+
+void TaskScheduler::run(int begin, int end, const RangeBody& body, int grain)
+{
+    const int count = end - begin;
+    if(count <= 0){
+        return;
+    }
+    if(grain <= 0){ // 每个线程平均约16个最小区间，足够窃取又不至于调度开销过大
+        grain = std::max(1, count / (m_slotCount * 16));
+    }
+    if(m_slotCount == 1 || count <= grain){
+        body.invoke(body.context, begin, end);
+        return;
+    }
+
+    // 外部线程在派发期间临时登记为最后一个队列的所有者，这样 body 内嵌套的 parallelFor 不会再次加锁
+    const bool external = t_scheduler != this;
+    std::unique_lock<std::mutex> externalLock(m_externalMutex, std::defer_lock);
+    const TaskScheduler* previousScheduler = t_scheduler;
+    const int previousSlot = t_slot;
+    if(external){
+        externalLock.lock();
+        t_scheduler = this;
+        t_slot = m_slotCount - 1;
+    }
+    const int slot = t_slot;
+    Job job;
+    job.body = body;
+    job.grain = grain;
+    job.remaining.store(count, std::memory_order_relaxed);
+
+    // fork：自旋中的线程看到 m_activeJobs 即开始窃取；只有已休眠的线程才需要经过条件变量
+    m_activeJobs.fetch_add(1);
+    m_generation.fetch_add(1);
+    if(m_parked.load() > 0){
+        { std::lock_guard<std::mutex> locker(m_parkMutex); }
+        m_parkCondition.notify_all();
+    }
+
+    execute({begin, end, &job}, slot);
+    // join：等待期间继续执行自己队列里剩下的或窃取来的任务
+    RangeTask task;
+    int waitSpins = 0;
+    while(job.remaining.load(std::memory_order_acquire) > 0){
+        if(popOrSteal(slot, task)){
+            execute(task, slot);
+        }
+        else if(++waitSpins % 256 == 0){
+            std::this_thread::yield(); // 剩余区间在被抢占的线程上时让它先运行
+        }
+        else{
+            _mm_pause();
+        }
+    }
+    m_activeJobs.fetch_sub(1);
+    t_scheduler = previousScheduler;
+    t_slot = previousSlot;
+}
+
+void TaskScheduler::workerLoop(int slot)
+{
+    t_scheduler = this;
+    t_slot = slot;
+    RangeTask task;
+    int stealAttempts = 0;
+    while(!m_stop.load(std::memory_order_relaxed)){
+        if(popOrSteal(slot, task)){
+            execute(task, slot);
+            stealAttempts = 0;
+            continue;
+        }
+        // 先读代数再判断是否有进行中的任务：夹在两次读取之间的派发会使代数变化，下面的自旋立即发现，不会错过它去休眠
+        const unsigned generation = m_generation.load(std::memory_order_acquire);
+        if(m_activeJobs.load(std::memory_order_acquire) > 0){
+            if(++stealAttempts % 256 == 0){
+                std::this_thread::yield();
+            }
+            else{
+                _mm_pause();
+            }
+            continue;
+        }
+        // 空闲：先自旋等待下一次派发(同一帧内的下一个阶段或下一个网格)，超时后才休眠
+        const auto parkTime = std::chrono::steady_clock::now() + std::chrono::microseconds(SPIN_BEFORE_PARK_US);
+        bool dispatched = false;
+        for(int spin = 1; !dispatched; spin++){
+            dispatched = m_generation.load(std::memory_order_relaxed) != generation || m_stop.load(std::memory_order_relaxed);
+            if((spin & 255) == 0){
+                if(std::chrono::steady_clock::now() > parkTime){
+                    break;
+                }
+                std::this_thread::yield(); // 线程数超过核数时把时间片让给正在干活的线程
+            }
+            else{
+                _mm_pause();
+            }
+        }
+        if(dispatched){
+            continue;
+        }
+        std::unique_lock<std::mutex> locker(m_parkMutex);
+        m_parked.fetch_add(1);
+        // 先登记休眠再检查代数：派发方先递增代数再读取休眠数，两者至少有一方能看到对方
+        m_parkCondition.wait(locker, [this, generation]() { return m_stop || m_generation.load() != generation; });
+        m_parked.fetch_sub(1);
+    }
+}
+
+bool TaskScheduler::popOrSteal(int slot, RangeTask& task)
+{
+    WorkQueue& own = m_queues[slot];
+    if(own.size.load(std::memory_order_relaxed) > 0){
+        std::lock_guard<SpinLock> locker(own.lock);
+        int size = own.size.load(std::memory_order_relaxed);
+        if(size > 0){
+            task = own.tasks[(own.head + size - 1) % QUEUE_CAPACITY];
+            own.size.store(size - 1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    const int start = static_cast<int>(nextRandom() % m_slotCount);
+    for(int i = 0; i < m_slotCount; i++){
+        int victim = (start + i) % m_slotCount;
+        if(victim == slot){
+            continue;
+        }
+        WorkQueue& queue = m_queues[victim];
+        if(queue.size.load(std::memory_order_relaxed) == 0){
+            continue;
+        }
+        std::lock_guard<SpinLock> locker(queue.lock);
+        int size = queue.size.load(std::memory_order_relaxed);
+        if(size > 0){
+            task = queue.tasks[queue.head];
+            queue.head = (queue.head + 1) % QUEUE_CAPACITY;
+            queue.size.store(size - 1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TaskScheduler::push(int slot, const RangeTask& task)
+{
+    WorkQueue& queue = m_queues[slot];
+    std::lock_guard<SpinLock> locker(queue.lock);
+    int size = queue.size.load(std::memory_order_relaxed);
+    if(size == QUEUE_CAPACITY){
+        return false;
+    }
+    queue.tasks[(queue.head + size) % QUEUE_CAPACITY] = task;
+    queue.size.store(size + 1, std::memory_order_relaxed);
+    return true;
+}
+
+void TaskScheduler::execute(RangeTask task, int slot)
+{
+    Job& job = *task.job;
+    while(task.begin < task.end){
+        const int size = task.end - task.begin;
+        // 惰性二分：自己的队列空了才拆分，剩余一半留给窃取者
+        if(size >= 2 * job.grain && m_queues[slot].size.load(std::memory_order_relaxed) == 0){
+            const int mid = task.begin + size / 2;
+            if(push(slot, {mid, task.end, task.job})){
+                task.end = mid;
+            }
+        }
+        const int chunkEnd = std::min(task.begin + job.grain, task.end);
+        job.body.invoke(job.body.context, task.begin, chunkEnd);
+        job.remaining.fetch_sub(chunkEnd - task.begin, std::memory_order_acq_rel);
+        task.begin = chunkEnd;
+    }
+}
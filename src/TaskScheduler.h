@@ -0,0 +1,99 @@
+#ifndef TASKSCHEDULER_H
+#define TASKSCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <immintrin.h>
+
+// 工作窃取调度器：每个工作线程一个双端队列，自己从尾部取任务，空闲线程从其他队列头部窃取(最早压入、范围最大的任务)。
+// parallelFor 采用惰性二分：执行者只在自己队列为空(说明任务可能已被窃取)时才把剩余范围对半拆出一半，
+// 负载均匀时几乎不拆分，三角形/tile 耗时不均时空闲线程总能窃取到剩余工作的一半。
+// 一帧内每个网格的每个阶段都是一次 fork-join：派发只递增代数并在有线程休眠时才唤醒，
+// 工作线程做完后先自旋一段时间再休眠，连续的派发不经过条件变量；派发过程不分配内存
+class TaskScheduler
+{
+public:
+    explicit TaskScheduler(int workerCount = 0); // <= 0 时为 hardware_concurrency；调用线程也参与执行，故只创建 workerCount-1 个后台线程
+    ~TaskScheduler();
+
+    // 把 [begin, end) 分成不小于 grain 的连续区间并行调用 body(区间起点, 区间终点)，全部完成后返回。
+    // grain <= 0 时按元素数与线程数自动选择。body 按引用使用，不应抛出异常
+    template<typename Body>
+    void parallelFor(int begin, int end, Body&& body, int grain = 0)
+    {
+        using BodyType = std::remove_reference_t<Body>;
+        RangeBody rangeBody{const_cast<void*>(static_cast<const void*>(&body)),
+                            [](void* context, int first, int last) { (*static_cast<BodyType*>(context))(first, last); }};
+        run(begin, end, rangeBody, grain);
+    }
+    int getWorkerCount() const { return m_slotCount; } // 同时执行任务的线程数(含调用线程)
+    int currentSlot() const; // 当前线程的队列序号 [0, getWorkerCount())，外部调用线程为最后一个
+
+    TaskScheduler(const TaskScheduler&) = delete;
+    TaskScheduler& operator=(const TaskScheduler&) = delete;
+
+private:
+    static constexpr int QUEUE_CAPACITY = 64; // 惰性二分下每层嵌套最多压入一个任务，满时不再拆分
+    static constexpr int SPIN_BEFORE_PARK_US = 200; // 无任务时自旋多久才休眠，覆盖一帧内相邻两次派发的间隔
+
+    struct RangeBody // 不持有所有权的函数引用，避免 std::function 的堆分配
+    {
+        void* context;
+        void (*invoke)(void*, int, int);
+    };
+    struct Job
+    {
+        RangeBody body;
+        int grain;
+        std::atomic<int> remaining; // 尚未执行完的元素数，归零即 join 完成
+    };
+    struct RangeTask
+    {
+        int begin;
+        int end;
+        Job* job;
+    };
+    class SpinLock
+    {
+    public:
+        void lock()
+        {
+            while(m_flag.test_and_set(std::memory_order_acquire)){
+                _mm_pause();
+            }
+        }
+        void unlock() { m_flag.clear(std::memory_order_release); }
+    private:
+        std::atomic_flag m_flag = ATOMIC_FLAG_INIT;
+    };
+    struct alignas(64) WorkQueue // 固定容量的环形双端队列，各占一条缓存行避免伪共享
+    {
+        SpinLock lock;
+        RangeTask tasks[QUEUE_CAPACITY];
+        int head{0}; // 窃取端
+        std::atomic<int> size{0}; // 不加锁判断是否为空
+    };
+
+    void run(int begin, int end, const RangeBody& body, int grain);
+    void workerLoop(int slot);
+    bool popOrSteal(int slot, RangeTask& task);
+    void execute(RangeTask task, int slot);
+    bool push(int slot, const RangeTask& task);
+
+    int m_slotCount;
+    std::vector<WorkQueue> m_queues; // [0, m_slotCount-1) 属于后台线程，最后一个属于外部调用线程
+    std::vector<std::thread> m_workers;
+    std::mutex m_externalMutex; // 外部线程同时只能有一个在提交(共用最后一个队列)
+    std::atomic<int> m_activeJobs{0}; // 有任务进行时空闲线程持续窃取
+    std::atomic<unsigned> m_generation{0}; // 每次派发加一，休眠的线程据此判断是否有新任务
+    std::atomic<int> m_parked{0}; // 正在条件变量上休眠的线程数，为 0 时派发不加锁也不通知
+    std::mutex m_parkMutex;
+    std::condition_variable m_parkCondition;
+    std::atomic<bool> m_stop{false};
+};
+
+#endif // TASKSCHEDULER_H
@@ -1,13 +1,132 @@
 #include "Texture.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "FunctionSIMD.h"
 
-bool Texture::loadFromImage(QString path)
+static bool isPowerOfTwo(int value)
+{
+    return value > 0 && (value & (value - 1)) == 0;
+}
+
+// 2x2 纹素逐通道求平均(四舍五入)
+static uint32_t averageTexels(uint32_t a, uint32_t b, uint32_t c, uint32_t d)
+{
+    uint32_t result = 0;
+    for(int shift = 0; shift < 32; shift += 8){
+        uint32_t sum = ((a >> shift) & 0xFF) + ((b >> shift) & 0xFF) + ((c >> shift) & 0xFF) + ((d >> shift) & 0xFF);
+        result |= ((sum + 2) / 4) << shift;
+    }
+    return result;
+}
+
+// 纹素下标：分块布局先定位 4x4 块，再取块内行主序偏移
+inline int Texture::texelIndex(const MipLevel& mip, int x, int y) const
+{
+    if(m_layout == TextureLayout::TILED){
+        return mip.offset + (y >> 2) * mip.pitch + ((x >> 2) << 4) + ((y & 3) << 2) + (x & 3);
+    }
+    return mip.offset + y * mip.pitch + x;
+}
+
+inline __m256i Texture::simdTexelIndex(const __m256i& x, const __m256i& y, const __m256i& offset, const __m256i& pitch) const
+{
+    if(m_layout == TextureLayout::TILED){
+        __m256i three = _mm256_set1_epi32(3);
+        __m256i blockRow = _mm256_mullo_epi32(_mm256_srli_epi32(y, 2), pitch);
+        __m256i blockColumn = _mm256_slli_epi32(_mm256_srli_epi32(x, 2), 4);
+        __m256i inBlock = _mm256_or_si256(_mm256_slli_epi32(_mm256_and_si256(y, three), 2), _mm256_and_si256(x, three));
+        return _mm256_add_epi32(_mm256_add_epi32(offset, blockRow), _mm256_add_epi32(blockColumn, inBlock));
+    }
+    return _mm256_add_epi32(offset, _mm256_add_epi32(_mm256_mullo_epi32(y, pitch), x));
+}
+
+static inline Color unpackTexel(uint32_t texel)
+{
+    return Color(((texel >> 16) & 0xFF) / 255.f,
+                 ((texel >> 8) & 0xFF) / 255.f,
+                 (texel & 0xFF) / 255.f);
+}
+
+bool Texture::loadFromImage(QString path, TextureLayout layout)
 {
     m_path = path;
-    if(m_texture.load(path))
+    QImage image;
+    if(image.load(path))
     {
         //m_texture.flip(Qt::Vertical); // 垂直翻转适应渲染
-        m_wide = m_texture.width();
-        m_height = m_texture.height();
+        // 不论解码出的格式(如 24 位 JPG、调色板 PNG)，统一转换为每像素32位的 ARGB32 后拷贝到自有数组
+        if(image.format() != QImage::Format_ARGB32){
+            image = image.convertToFormat(QImage::Format_ARGB32);
+        }
+        m_wide = image.width();
+        m_height = image.height();
+        m_wrapMaskX = isPowerOfTwo(m_wide) ? m_wide - 1 : -1;
+        m_wrapMaskY = isPowerOfTwo(m_height) ? m_height - 1 : -1;
+
+        // 各层宽高向下取整减半(不小于1)，先按行主序生成整条 mip 链
+        std::vector<MipLevel> linearLevels;
+        int linearTotal = 0;
+        for(int w = m_wide, h = m_height; ; w = std::max(1, w / 2), h = std::max(1, h / 2)){
+            linearLevels.push_back({w, h, linearTotal, w});
+            linearTotal += w * h;
+            if(w == 1 && h == 1){
+                break;
+            }
+        }
+        std::vector<uint32_t> chain(linearTotal);
+        for(int y = 0; y < m_height; y++){
+            std::memcpy(chain.data() + y * m_wide, image.constScanLine(y), sizeof(uint32_t) * m_wide);
+        }
+        // 逐层 2x2 盒式滤波，奇数尺寸时最后一行/列钳制到边缘
+        for(size_t level = 1; level < linearLevels.size(); level++){
+            const MipLevel& src = linearLevels[level - 1];
+            const MipLevel& dst = linearLevels[level];
+            const uint32_t* srcTexels = chain.data() + src.offset;
+            uint32_t* dstTexels = chain.data() + dst.offset;
+            for(int y = 0; y < dst.height; y++){
+                const uint32_t* row0 = srcTexels + std::min(2 * y, src.height - 1) * src.wide;
+                const uint32_t* row1 = srcTexels + std::min(2 * y + 1, src.height - 1) * src.wide;
+                for(int x = 0; x < dst.wide; x++){
+                    const int x0 = std::min(2 * x, src.wide - 1);
+                    const int x1 = std::min(2 * x + 1, src.wide - 1);
+                    dstTexels[y * dst.wide + x] = averageTexels(row0[x0], row0[x1], row1[x0], row1[x1]);
+                }
+            }
+        }
+
+        // 再按所选布局放入对齐的自有数组；分块时每层宽高补齐到 4 的倍数，每块正好占一条缓存行
+        m_layout = layout;
+        m_mipLevels.clear();
+        int total = 0;
+        for(const MipLevel& mip : linearLevels){
+            if(m_layout == TextureLayout::TILED){
+                const int pitch = ((mip.wide + 3) / 4) * 16;
+                m_mipLevels.push_back({mip.wide, mip.height, total, pitch});
+                total += ((mip.height + 3) / 4) * pitch;
+            }
+            else{
+                m_mipLevels.push_back(mip);
+                total += mip.wide * mip.height;
+            }
+        }
+        uint32_t* texels = static_cast<uint32_t*>(_mm_malloc(sizeof(uint32_t) * total, 64));
+        if(m_layout == TextureLayout::TILED){
+            std::memset(texels, 0, sizeof(uint32_t) * total); // 补齐的纹素不会被采样，清零保证内容确定
+            for(size_t level = 0; level < m_mipLevels.size(); level++){
+                const MipLevel& src = linearLevels[level];
+                const MipLevel& dst = m_mipLevels[level];
+                for(int y = 0; y < src.height; y++){
+                    for(int x = 0; x < src.wide; x++){
+                        texels[texelIndex(dst, x, y)] = chain[src.offset + y * src.wide + x];
+                    }
+                }
+            }
+        }
+        else{
+            std::memcpy(texels, chain.data(), sizeof(uint32_t) * total);
+        }
+        m_texels.reset(texels, [](const uint32_t* data){ _mm_free(const_cast<uint32_t*>(data)); });
         return true;
     }
     return false;
@@ -15,33 +134,31 @@ bool Texture::loadFromImage(QString path)
 
 Color Texture::sample2D(const Coord2D& coord)
 {
-    // int x = static_cast<int>(coord.x * m_wide); // 或者 floor(coord.x * m_wide)
-    // int y = static_cast<int>((1.0 - coord.y) * m_height); // Y轴反转
-    // // 钳制到有效范围
-    // x = std::clamp(x, 0, m_wide - 1);
-    // y = std::clamp(y, 0, m_height - 1);
-
-    // QRgb rgb = m_texture.pixel(x, y);
-    // return Color(qRed(rgb) / 255.f, qGreen(rgb) / 255.f, qBlue(rgb) / 255.f);
-
-    int x = static_cast<int>(coord.x * m_wide - 0.5f) % m_wide;
-    int y = static_cast<int>(coord.y * m_height - 0.5f) % m_height;
-    x = x < 0 ? m_wide + x : x;
-    y = y < 0 ? m_height + y : y;
-<<<<<<< HEAD
-    return Color(m_texture.pixelColor(x, y).red() / 255.f, m_texture.pixelColor(x, y).green() / 255.f, m_texture.pixelColor(x, y).blue() / 255.f);
-}
+    if(!m_texels){return Color(1.f);}
 
-=======
-    return Color(m_texture.pixelColor(x, y).red() / 255.f,
-                 m_texture.pixelColor(x, y).green() / 255.f,
-                 m_texture.pixelColor(x, y).blue() / 255.f);
+    int x = static_cast<int>(coord.x * m_wide - 0.5f);
+    int y = static_cast<int>(coord.y * m_height - 0.5f);
+    if(m_wrapMaskX >= 0){ // 2的幂：按位与即可回绕，负数同样正确
+        x &= m_wrapMaskX;
+    }
+    else{
+        x %= m_wide;
+        x = x < 0 ? m_wide + x : x;
+    }
+    if(m_wrapMaskY >= 0){
+        y &= m_wrapMaskY;
+    }
+    else{
+        y %= m_height;
+        y = y < 0 ? m_height + y : y;
+    }
+    return unpackTexel(m_texels.get()[texelIndex(m_mipLevels[0], x, y)]);
 }
 
 SimdColor Texture::simdSample2D(const SimdVector2D& coordSimd)
 {
     // 异常处理
-    if(m_wide <= 0 || m_height <= 0 || m_texture.isNull()){return {_mm256_set1_ps(1.f), _mm256_set1_ps(1.f), _mm256_set1_ps(1.f)};}
+    if(!m_texels){return {_mm256_set1_ps(1.f), _mm256_set1_ps(1.f), _mm256_set1_ps(1.f)};}
 
     // 将wide height simd化
     __m256 simdWideF = _mm256_set1_ps(static_cast<float>(m_wide));
@@ -58,35 +175,44 @@ SimdColor Texture::simdSample2D(const SimdVector2D& coordSimd)
     __m256i simdWideI = _mm256_set1_epi32(m_wide);
     __m256i simdHeightI = _mm256_set1_epi32(m_height);
     __m256i zeroI = _mm256_setzero_si256();
-    //对应非simd的 (coord.x(.y) * wide(height) - 0.5) % wide(height)余数的浮点值
-    __m256 qxF = _mm256_div_ps(scaledTextureX, simdWideF);
-    __m256 qyF = _mm256_div_ps(scaledTextureY, simdHeightF);
-    // 将因数转换为整数
-    __m256i qx = _mm256_cvttps_epi32(qxF);
-    __m256i qy = _mm256_cvttps_epi32(qyF);
-    // 将原值pixelX减去因数乘屏幕数据(wide height)得到余数
-    __m256i rx = _mm256_sub_epi32(pixelX, _mm256_mullo_epi32(qx, simdWideI));
-    __m256i ry = _mm256_sub_epi32(pixelY, _mm256_mullo_epi32(qy, simdHeightI));
-
-    // 对应非simd的 x = x < 0 ? m_wide + x : x;
-    __m256i negRxMask = _mm256_cmpgt_epi32(zeroI, rx);
-    __m256i wrappedX  = _mm256_add_epi32(rx, _mm256_and_si256(negRxMask, simdWideI));
-    __m256i negRyMask = _mm256_cmpgt_epi32(zeroI, ry);
-    __m256i wrappedY  = _mm256_add_epi32(ry, _mm256_and_si256(negRyMask, simdHeightI));
-
-    const uchar* scan0 = m_texture.constBits();
-    int bytesPerLine = m_texture.bytesPerLine();
-    int bytesPerPixel = m_texture.depth() / 8;
+    __m256i wrappedX, wrappedY;
+    if(m_wrapMaskX >= 0 && m_wrapMaskY >= 0){
+        // 宽高均为2的幂：按位与回绕，结果总在图像内
+        wrappedX = _mm256_and_si256(pixelX, _mm256_set1_epi32(m_wrapMaskX));
+        wrappedY = _mm256_and_si256(pixelY, _mm256_set1_epi32(m_wrapMaskY));
+    }
+    else{
+        //对应非simd的 (coord.x(.y) * wide(height) - 0.5) % wide(height)余数的浮点值
+        __m256 qxF = _mm256_div_ps(scaledTextureX, simdWideF);
+        __m256 qyF = _mm256_div_ps(scaledTextureY, simdHeightF);
+        // 将因数转换为整数
+        __m256i qx = _mm256_cvttps_epi32(qxF);
+        __m256i qy = _mm256_cvttps_epi32(qyF);
+        // 将原值pixelX减去因数乘屏幕数据(wide height)得到余数
+        __m256i rx = _mm256_sub_epi32(pixelX, _mm256_mullo_epi32(qx, simdWideI));
+        __m256i ry = _mm256_sub_epi32(pixelY, _mm256_mullo_epi32(qy, simdHeightI));
+
+        // 浮点除法的舍入可能让商差 1，余数落在 [-wide, 2 * wide) 内，修正回 [0, wide)
+        // (同时对应非simd的 x = x < 0 ? m_wide + x : x;)
+        __m256i negRxMask = _mm256_cmpgt_epi32(zeroI, rx);
+        wrappedX  = _mm256_add_epi32(rx, _mm256_and_si256(negRxMask, simdWideI));
+        wrappedX  = _mm256_sub_epi32(wrappedX, _mm256_and_si256(_mm256_cmpgt_epi32(wrappedX, _mm256_sub_epi32(simdWideI, _mm256_set1_epi32(1))), simdWideI));
+        __m256i negRyMask = _mm256_cmpgt_epi32(zeroI, ry);
+        wrappedY  = _mm256_add_epi32(ry, _mm256_and_si256(negRyMask, simdHeightI));
+        wrappedY  = _mm256_sub_epi32(wrappedY, _mm256_and_si256(_mm256_cmpgt_epi32(wrappedY, _mm256_sub_epi32(simdHeightI, _mm256_set1_epi32(1))), simdHeightI));
+        // 坐标超出 int 范围时取模结果无意义，钳制到图像内避免越界读取
+        wrappedX = _mm256_min_epi32(_mm256_max_epi32(wrappedX, zeroI), _mm256_sub_epi32(simdWideI, _mm256_set1_epi32(1)));
+        wrappedY = _mm256_min_epi32(_mm256_max_epi32(wrappedY, zeroI), _mm256_sub_epi32(simdHeightI, _mm256_set1_epi32(1)));
+    }
+
     SimdColor sampleColor = {_mm256_setzero_ps(),
                              _mm256_setzero_ps(),
                              _mm256_setzero_ps()};
 
-    __m256i simdBytPerLine = _mm256_set1_epi32(bytesPerLine);
-    __m256i addressOffset = _mm256_add_epi32(_mm256_mullo_epi32(wrappedY, simdBytPerLine), _mm256_mullo_epi32(wrappedX, _mm256_set1_epi32(bytesPerPixel)));
-    __m256i pixelIndices = _mm256_srli_epi32(addressOffset, 2);
-
-    const int* baseIntPtr = reinterpret_cast<const int*>(scan0);
-    __m256i bgraPixels = _mm256_i32gather_epi32(baseIntPtr, pixelIndices, 4);
+    // 按布局求纹素下标，按32位 gather
+    const MipLevel& base = m_mipLevels[0];
+    __m256i texelIndices = simdTexelIndex(wrappedX, wrappedY, _mm256_set1_epi32(base.offset), _mm256_set1_epi32(base.pitch));
+    __m256i bgraPixels = _mm256_i32gather_epi32(reinterpret_cast<const int*>(m_texels.get()), texelIndices, 4);
 
     __m256i red   = _mm256_and_si256(_mm256_srli_epi32(bgraPixels, 16), _mm256_set1_epi32(0x000000FF));
     __m256i green = _mm256_and_si256(_mm256_srli_epi32(bgraPixels, 8), _mm256_set1_epi32(0x000000FF));
@@ -102,24 +228,150 @@ SimdColor Texture::simdSample2D(const SimdVector2D& coordSimd)
     sampleColor.b = _mm256_mul_ps(blueFinal, inv255);
     return sampleColor;
 }
-/*else {
-        // 不是ARGB32/RGB32 或不支持 gather，使用低效回退
-        int pixelXArr[8];
-        int pixelYArr[8];
-        _mm256_storeu_si256((__m256i*)pixelXArr, wrappedX);
-        _mm256_storeu_si256((__m256i*)pixelYArr, wrappedY);
-        float r[8];
-        float g[8];
-        float b[8];
-        for(int i = 0; i < 8; ++i) {
-            QColor qc = m_texture.pixelColor(pixelXArr[i], pixelYArr[i]); // SLOW SCALAR CALL
-            r[i] = qc.redF();
-            g[i] = qc.greenF();
-            b[i] = qc.blueF();
-        }
-        sampleColor.r = _mm256_loadu_ps(r);
-        sampleColor.g = _mm256_loadu_ps(g);
-        sampleColor.b = _mm256_loadu_ps(b);
-    }*/
 
->>>>>>> future
+// LOD = log2(纹理坐标在屏幕 x、y 方向上较长的那个导数的纹素长度)，钳制到已有层级范围
+float Texture::computeLod(const Vector2D& ddx, const Vector2D& ddy) const
+{
+    const float wide = static_cast<float>(m_wide), height = static_cast<float>(m_height);
+    const float lengthX = (ddx.x * wide) * (ddx.x * wide) + (ddx.y * height) * (ddx.y * height);
+    const float lengthY = (ddy.x * wide) * (ddy.x * wide) + (ddy.y * height) * (ddy.y * height);
+    float lod = 0.5f * std::log2(std::max(std::max(lengthX, lengthY), 1e-20f)); // 对平方长度取对数再减半，省去开方
+    if(!(lod > 0.f)){ // 同时处理 NaN
+        return 0.f;
+    }
+    return std::min(lod, static_cast<float>(m_mipLevels.size() - 1));
+}
+
+__m256 Texture::simdComputeLod(const SimdVector2D& ddx, const SimdVector2D& ddy) const
+{
+    __m256 wide = _mm256_set1_ps(static_cast<float>(m_wide));
+    __m256 height = _mm256_set1_ps(static_cast<float>(m_height));
+    __m256 dxU = _mm256_mul_ps(ddx.x, wide), dxV = _mm256_mul_ps(ddx.y, height);
+    __m256 dyU = _mm256_mul_ps(ddy.x, wide), dyV = _mm256_mul_ps(ddy.y, height);
+    __m256 lengthX = _mm256_fmadd_ps(dxU, dxU, _mm256_mul_ps(dxV, dxV));
+    __m256 lengthY = _mm256_fmadd_ps(dyU, dyU, _mm256_mul_ps(dyV, dyV));
+    __m256 lengthMax = _mm256_max_ps(_mm256_max_ps(lengthX, lengthY), _mm256_set1_ps(1e-20f));
+    __m256 lod = _mm256_mul_ps(_mm256_set1_ps(0.5f), simd_log2_ps(lengthMax));
+    // max_ps 在第一个操作数为 NaN 时返回第二个操作数，NaN 通道落到第 0 层
+    lod = _mm256_max_ps(lod, _mm256_setzero_ps());
+    return _mm256_min_ps(lod, _mm256_set1_ps(static_cast<float>(m_mipLevels.size() - 1)));
+}
+
+// 在指定层级上双线性采样，纹素中心位于 (i + 0.5) / wide，边缘按重复方式回绕
+Color Texture::sampleBilinear(int level, const Coord2D& coord) const
+{
+    const MipLevel& mip = m_mipLevels[level];
+    const float tx = (coord.x - std::floor(coord.x)) * mip.wide - 0.5f;
+    const float ty = (coord.y - std::floor(coord.y)) * mip.height - 0.5f;
+    const float x0F = std::floor(tx), y0F = std::floor(ty);
+    const float fx = tx - x0F, fy = ty - y0F;
+    // tx 位于 [-0.5, wide - 0.5)，x0 只可能越界一格
+    int x0 = static_cast<int>(x0F), y0 = static_cast<int>(y0F);
+    x0 = x0 < 0 ? x0 + mip.wide : x0;
+    y0 = y0 < 0 ? y0 + mip.height : y0;
+    const int x1 = x0 + 1 >= mip.wide ? 0 : x0 + 1;
+    const int y1 = y0 + 1 >= mip.height ? 0 : y0 + 1;
+    const uint32_t* texels = m_texels.get();
+    Color c00 = unpackTexel(texels[texelIndex(mip, x0, y0)]);
+    Color c10 = unpackTexel(texels[texelIndex(mip, x1, y0)]);
+    Color c01 = unpackTexel(texels[texelIndex(mip, x0, y1)]);
+    Color c11 = unpackTexel(texels[texelIndex(mip, x1, y1)]);
+    Color top = c00 + (c10 - c00) * fx;
+    Color bottom = c01 + (c11 - c01) * fx;
+    return top + (bottom - top) * fy;
+}
+
+Color Texture::sample2D(const Coord2D& coord, const Vector2D& ddx, const Vector2D& ddy, TextureFilter filter)
+{
+    if(!m_texels){return Color(1.f);}
+    if(filter == TextureFilter::NEAREST){
+        return sample2D(coord);
+    }
+    const float lod = computeLod(ddx, ddy);
+    if(filter == TextureFilter::BILINEAR){
+        return sampleBilinear(static_cast<int>(lod + 0.5f), coord);
+    }
+    const int level0 = static_cast<int>(lod);
+    const float t = lod - level0;
+    Color c0 = sampleBilinear(level0, coord);
+    if(t <= 0.f){ // 已是最后一层时 lod 被钳制为整数，t 为 0
+        return c0;
+    }
+    return c0 + (sampleBilinear(level0 + 1, coord) - c0) * t;
+}
+
+SimdColor Texture::simdSampleBilinear(__m256i level, const SimdVector2D& coordSimd) const
+{
+    // 按通道从层级表中 gather 各自层级的宽、高与偏移
+    static_assert(sizeof(MipLevel) == 4 * sizeof(int), "MipLevel must be four packed ints");
+    const int* levelTable = reinterpret_cast<const int*>(m_mipLevels.data());
+    __m256i levelIndex = _mm256_slli_epi32(level, 2);
+    __m256i wideI = _mm256_i32gather_epi32(levelTable, levelIndex, 4);
+    __m256i heightI = _mm256_i32gather_epi32(levelTable + 1, levelIndex, 4);
+    __m256i offsetI = _mm256_i32gather_epi32(levelTable + 2, levelIndex, 4);
+    __m256i pitchI = _mm256_i32gather_epi32(levelTable + 3, levelIndex, 4);
+
+    __m256 half = _mm256_set1_ps(0.5f);
+    // 取小数部分实现重复回绕；max_ps 顺带把 NaN 通道变为 0，避免越界 gather
+    __m256 fracU = _mm256_max_ps(_mm256_sub_ps(coordSimd.x, _mm256_floor_ps(coordSimd.x)), _mm256_setzero_ps());
+    __m256 fracV = _mm256_max_ps(_mm256_sub_ps(coordSimd.y, _mm256_floor_ps(coordSimd.y)), _mm256_setzero_ps());
+    __m256 tx = _mm256_sub_ps(_mm256_mul_ps(fracU, _mm256_cvtepi32_ps(wideI)), half);
+    __m256 ty = _mm256_sub_ps(_mm256_mul_ps(fracV, _mm256_cvtepi32_ps(heightI)), half);
+    __m256 x0F = _mm256_floor_ps(tx), y0F = _mm256_floor_ps(ty);
+    __m256 fx = _mm256_sub_ps(tx, x0F), fy = _mm256_sub_ps(ty, y0F);
+
+    // 与标量版相同的回绕：x0 = -1 时加 wide，x1 = wide 时回到 0
+    __m256i zeroI = _mm256_setzero_si256();
+    __m256i oneI = _mm256_set1_epi32(1);
+    __m256i x0 = _mm256_cvttps_epi32(x0F), y0 = _mm256_cvttps_epi32(y0F);
+    x0 = _mm256_add_epi32(x0, _mm256_and_si256(_mm256_cmpgt_epi32(zeroI, x0), wideI));
+    y0 = _mm256_add_epi32(y0, _mm256_and_si256(_mm256_cmpgt_epi32(zeroI, y0), heightI));
+    __m256i x1 = _mm256_add_epi32(x0, oneI), y1 = _mm256_add_epi32(y0, oneI);
+    x1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(x1, wideI), x1);
+    y1 = _mm256_andnot_si256(_mm256_cmpeq_epi32(y1, heightI), y1);
+
+    const int* texels = reinterpret_cast<const int*>(m_texels.get());
+    __m256i t00 = _mm256_i32gather_epi32(texels, simdTexelIndex(x0, y0, offsetI, pitchI), 4);
+    __m256i t10 = _mm256_i32gather_epi32(texels, simdTexelIndex(x1, y0, offsetI, pitchI), 4);
+    __m256i t01 = _mm256_i32gather_epi32(texels, simdTexelIndex(x0, y1, offsetI, pitchI), 4);
+    __m256i t11 = _mm256_i32gather_epi32(texels, simdTexelIndex(x1, y1, offsetI, pitchI), 4);
+
+    __m256i channelMask = _mm256_set1_epi32(0xFF);
+    __m256 inv255 = _mm256_set1_ps(1.f / 255.f);
+    auto filterChannel = [&](int shift) {
+        __m256 c00 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t00, shift), channelMask));
+        __m256 c10 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t10, shift), channelMask));
+        __m256 c01 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t01, shift), channelMask));
+        __m256 c11 = _mm256_cvtepi32_ps(_mm256_and_si256(_mm256_srli_epi32(t11, shift), channelMask));
+        __m256 top = _mm256_fmadd_ps(_mm256_sub_ps(c10, c00), fx, c00);
+        __m256 bottom = _mm256_fmadd_ps(_mm256_sub_ps(c11, c01), fx, c01);
+        return _mm256_mul_ps(_mm256_fmadd_ps(_mm256_sub_ps(bottom, top), fy, top), inv255);
+    };
+    return {filterChannel(16), filterChannel(8), filterChannel(0)};
+}
+
+SimdColor Texture::simdSample2D(const SimdVector2D& coordSimd, const SimdVector2D& ddx, const SimdVector2D& ddy, TextureFilter filter)
+{
+    if(!m_texels){return {_mm256_set1_ps(1.f), _mm256_set1_ps(1.f), _mm256_set1_ps(1.f)};}
+    if(filter == TextureFilter::NEAREST){
+        return simdSample2D(coordSimd);
+    }
+    __m256 lod = simdComputeLod(ddx, ddy);
+    if(filter == TextureFilter::BILINEAR){
+        return simdSampleBilinear(_mm256_cvttps_epi32(_mm256_add_ps(lod, _mm256_set1_ps(0.5f))), coordSimd);
+    }
+    __m256 level0F = _mm256_floor_ps(lod);
+    __m256 t = _mm256_sub_ps(lod, level0F);
+    __m256i level0 = _mm256_cvttps_epi32(level0F);
+    SimdColor c0 = simdSampleBilinear(level0, coordSimd);
+    if(_mm256_movemask_ps(_mm256_cmp_ps(t, _mm256_setzero_ps(), _CMP_GT_OQ)) == 0){ // 8 个通道都落在整数层级上
+        return c0;
+    }
+    // t 为 0 的通道(包括最后一层)下一层的结果不参与插值，这里把层级钳制住避免越界
+    __m256i level1 = _mm256_min_epi32(_mm256_add_epi32(level0, _mm256_set1_epi32(1)),
+                                      _mm256_set1_epi32(static_cast<int>(m_mipLevels.size()) - 1));
+    SimdColor c1 = simdSampleBilinear(level1, coordSimd);
+    return {_mm256_fmadd_ps(_mm256_sub_ps(c1.r, c0.r), t, c0.r),
+            _mm256_fmadd_ps(_mm256_sub_ps(c1.g, c0.g), t, c0.g),
+            _mm256_fmadd_ps(_mm256_sub_ps(c1.b, c0.b), t, c0.b)};
+}
@@ -1,10 +1,10 @@
 #ifndef TEXTURE_H
 #define TEXTURE_H
 
-<<<<<<< HEAD
-=======
 #include <iostream>
->>>>>>> future
+#include <memory>
+#include <cstdint>
+#include <vector>
 #include <QImage>
 #include <QString>
 #include "BasicDataStructure.h"
@@ -16,21 +16,41 @@ public:
     QString m_path;
 
     Texture() = default;
-    bool loadFromImage(QString path);
-    Color sample2D(const Coord2D& coord);
-<<<<<<< HEAD
-=======
+    bool loadFromImage(QString path, TextureLayout layout = TextureLayout::TILED);
+    Color sample2D(const Coord2D& coord); // 最近点采样原始层级
     SimdColor simdSample2D(const SimdVector2D& coordSimd);
->>>>>>> future
+    // 按纹理坐标的屏幕空间导数选择 mip 层级并过滤
+    Color sample2D(const Coord2D& coord, const Vector2D& ddx, const Vector2D& ddy, TextureFilter filter);
+    SimdColor simdSample2D(const SimdVector2D& coordSimd, const SimdVector2D& ddx, const SimdVector2D& ddy, TextureFilter filter);
+    int getMipLevelCount() const {return static_cast<int>(m_mipLevels.size());}
+    bool isLoaded() const {return m_texels != nullptr;}
 private:
+    struct MipLevel
+    {
+        int wide;
+        int height;
+        int offset; // 该层首个纹素在 m_texels 中的下标
+        int pitch;  // 行主序时为一行的纹素数；分块时为一行块的纹素数
+    };
+    int texelIndex(const MipLevel& mip, int x, int y) const;
+    __m256i simdTexelIndex(const __m256i& x, const __m256i& y, const __m256i& offset, const __m256i& pitch) const;
+    float computeLod(const Vector2D& ddx, const Vector2D& ddy) const;
+    __m256 simdComputeLod(const SimdVector2D& ddx, const SimdVector2D& ddy) const;
+    Color sampleBilinear(int level, const Coord2D& coord) const;
+    SimdColor simdSampleBilinear(__m256i level, const SimdVector2D& coordSimd) const;
+
     enum class TextureColorType
     {
         DIFFUSE,
         SPECLUAR
     };
-    int m_wide;
-    int m_height;
-    QImage m_texture;
+    int m_wide{0};
+    int m_height{0};
+    int m_wrapMaskX{-1}; // 宽为2的幂时为 wide - 1，用按位与代替取模；否则为 -1
+    int m_wrapMaskY{-1};
+    TextureLayout m_layout{TextureLayout::LINEAR};
+    std::shared_ptr<const uint32_t> m_texels; // 加载时解码好的 64 字节对齐纹素(0xAARRGGBB)，各 mip 层级依次排列；多个 Texture 拷贝共享同一份数据
+    std::vector<MipLevel> m_mipLevels; // 第 0 层为原图，逐层宽高减半直到 1x1
 };
 
 #endif // TEXTURE_H
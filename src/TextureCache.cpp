@@ -0,0 +1,35 @@
+#include "TextureCache.h"
+#include <algorithm>
+
+TextureCache& TextureCache::getInstance()
+{
+    static TextureCache cache;
+    return cache;
+}
+
+std::shared_future<Texture> TextureCache::load(const QString& path, TextureLayout layout)
+{
+    std::string key = path.toStdString() + '|' + std::to_string(static_cast<int>(layout));
+    std::lock_guard<std::mutex> locker(m_mutex);
+    auto it = m_textures.find(key);
+    if(it != m_textures.end()){
+        return it->second;
+    }
+    if(!m_decodePool){
+        int threads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        m_decodePool = std::make_unique<ThreadPool>(threads, threads);
+    }
+    std::shared_future<Texture> future = m_decodePool->addTask([path, layout]() {
+        Texture texture;
+        texture.loadFromImage(path, layout);
+        return texture;
+    }).share();
+    m_textures.emplace(std::move(key), future);
+    return future;
+}
+
+void TextureCache::clear()
+{
+    std::lock_guard<std::mutex> locker(m_mutex);
+    m_textures.clear();
+}
@@ -0,0 +1,32 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <QString>
+#include "Texture.h"
+#include "threadpool.h"
+
+// 进程级纹理缓存：纹理在工作线程池上异步解码，同一文件(与布局)只解码一次，
+// 重新打开模型或多个模型共用纹理时直接复用已解码的纹素(Texture 拷贝共享纹素数据)
+class TextureCache
+{
+public:
+    static TextureCache& getInstance();
+    std::shared_future<Texture> load(const QString& path, TextureLayout layout); // 立即返回，解码失败时结果的 isLoaded() 为 false
+    void clear(); // 释放缓存持有的纹理(已被模型拷贝的纹理不受影响)
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+private:
+    TextureCache() = default;
+
+    std::mutex m_mutex;
+    std::unique_ptr<ThreadPool> m_decodePool; // 首次加载时创建
+    std::unordered_map<std::string, std::shared_future<Texture>> m_textures; // 键为 路径|布局
+};
+
+#endif // TEXTURECACHE_H
@@ -0,0 +1,83 @@
+#ifndef HEADLESSCOMMON_H
+#define HEADLESSCOMMON_H
+
+#include <iostream>
+#include <memory>
+#include "Camera.h"
+#include "Model.h"
+#include "BlinnPhongShader.h"
+#include "SRendererDevice.h"
+#include "BasicDataStructure.h"
+
+// 无界面工具(渲染器/基准测试)共用的设备、相机与单帧渲染流程
+
+static constexpr float HEADLESS_SHININESS = 150.f;
+static constexpr float HEADLESS_CAMERA_FAR = 100.f;
+
+inline SRendererDevice& initHeadlessDevice(int wide, int height)
+{
+    SRendererDevice::init(wide, height);
+    auto& renderDevice = SRendererDevice::getInstance();
+    renderDevice.m_shader = std::make_unique<BlinnPhongShader>();
+
+    // 与 Widget::initUi 的默认光照保持一致
+    Light light;
+    light.dir = Vector4D(0.f, 0.f, -1.f, 0.f);
+    light.ambient = Color(102.f / 255.f);
+    light.diffuse = Color(153.f / 255.f);
+    light.specular = Color(1.f);
+    renderDevice.m_shader->m_lightList.push_back(light);
+    renderDevice.m_shader->m_material.shininess = HEADLESS_SHININESS;
+    return renderDevice;
+}
+
+inline Camera makeHeadlessCamera(int wide, int height, Model& model)
+{
+    Camera camera(static_cast<float>(wide) / static_cast<float>(height), HEADLESS_CAMERA_FAR);
+    camera.m_fov = 60.f;
+    camera.m_zNear = 1.f;
+    camera.setCamera(model.m_centre, model.getYRange());
+    return camera;
+}
+
+// 清屏、更新变换矩阵并绘制一帧(与 RenderWidget::render 一致，不含输入处理)
+inline void renderHeadlessFrame(SRendererDevice& renderDevice, Model& model, Camera& camera)
+{
+    renderDevice.clearBuffer();
+    renderDevice.m_shader->m_modelTransformation = model.getModelTansformation();
+    renderDevice.m_shader->m_viewTransformation = camera.getViewMatrix();
+    renderDevice.m_shader->m_projectionTransformation = camera.getProjectionMatrix();
+    renderDevice.m_shader->m_eyePos = camera.m_position;
+    model.draw();
+    renderDevice.resolveFrame();
+}
+
+// 按帧平均打印管线统计
+inline void printPipelineStatistics(const PipelineStatistics& stats, int frames)
+{
+    const double n = frames > 0 ? frames : 1;
+    std::cout << "pipeline (per frame):\n"
+              << "  meshes submitted: " << stats.meshesSubmitted / n
+              << "  frustum culled: " << stats.meshesCulled / n << "\n"
+              << "  meshlets submitted: " << stats.meshletsSubmitted / n
+              << "  frustum culled: " << stats.meshletsFrustumCulled / n
+              << "  backface culled: " << stats.meshletsBackfaceCulled / n << "\n"
+              << "  vertices shaded: " << stats.verticesShaded / n << "\n"
+              << "  triangles submitted: " << stats.trianglesSubmitted / n
+              << "  rejected: " << stats.trianglesRejected / n
+              << "  clipped: " << stats.trianglesClipped / n
+              << "  culled: " << stats.trianglesCulled / n << "\n"
+              << "  pixels tested: " << stats.pixelsTested / n
+              << "  inside: " << stats.fragmentsInside / n
+              << "  depth passed: " << stats.fragmentsDepthPassed / n
+              << "  shaded: " << stats.fragmentsShaded / n << "\n"
+              << "  hi-z rejected triangles: " << stats.trianglesHiZRejected / n
+              << "  pixels: " << stats.pixelsHiZRejected / n << "\n"
+              << "  vertex: " << stats.vertexMs / n << " ms"
+              << "  clip: " << stats.clipMs / n << " ms"
+              << "  raster: " << stats.rasterMs / n << " ms"
+              << "  shade: " << stats.shadeMs / n << " ms"
+              << "  (thread time)  render: " << stats.renderMs / n << " ms" << std::endl;
+}
+
+#endif // HEADLESSCOMMON_H
@@ -0,0 +1,292 @@
+// 无界面渲染器：不依赖 RenderWidget / QApplication，直接驱动 SRendererDevice
+// 用法示例：SoftRendererHeadless res/models/african_head/african_head.obj -n 200 -o frame.png -s stats.csv
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "HeadlessCommon.h"
+
+// 着色器与网格依赖的全局开关(GUI 版本定义在 Widget.cpp 中)
+bool SHADERTEXTURE = true;
+bool AMBIENT = false;
+bool DIFFUSE = false;
+bool SPECULAR = false;
+bool FXAA = false;
+
+struct HeadlessOptions
+{
+    QString modelPath;
+    QString outputPath; // 为空则不保存图片，含 %1 时逐帧保存
+    QString statsPath;  // 为空则不写逐帧耗时
+    int frames{100};
+    int width{800};
+    int height{600};
+    float orbitDegrees{0.f}; // 每帧相机绕目标旋转的角度
+    RendererMode mode{RendererMode::Rasterization};
+    QString thread{"pool"};
+    bool simd{true};
+    bool simdShading{true};
+    bool pipelineStats{false};
+    bool tileBinning{true};
+    bool visibilityBuffer{false};
+    bool frustumCulling{true};
+    bool meshletCulling{true};
+    TextureFilter textureFilter{TextureFilter::TRILINEAR};
+    TextureLayout textureLayout{TextureLayout::TILED};
+    bool meshCache{true};    // 读写模型旁的二进制网格缓存
+    bool nativeObj{true};    // OBJ 使用原生解析器
+    MeshOptimization meshOptimization{MeshOptimization::OVERDRAW};
+    bool checkScalar{false}; // 用标量参考路径重新渲染最后一帧并比较
+    int tolerance{2};        // 允许的单通道最大差值
+};
+
+static bool parseOptions(const QCoreApplication& app, HeadlessOptions& opt)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SoftRenderer headless frame renderer");
+    parser.addHelpOption();
+    parser.addPositionalArgument("model", "Model file to render (.obj etc.)");
+
+    QCommandLineOption framesOpt({"n", "frames"}, "Number of frames to render.", "count", "100");
+    QCommandLineOption widthOpt({"W", "width"}, "Frame buffer width.", "pixels", "800");
+    QCommandLineOption heightOpt({"H", "height"}, "Frame buffer height.", "pixels", "600");
+    QCommandLineOption modeOpt({"m", "mode"}, "Render mode: raster, mesh or vertex.", "mode", "raster");
+    QCommandLineOption threadOpt({"t", "thread"}, "Triangle dispatch: pool, tbb or single.", "kind", "pool");
+    QCommandLineOption scalarOpt("scalar", "Disable the SIMD rasterizer.");
+    QCommandLineOption scalarShadingOpt("scalar-shading", "Keep the SIMD rasterizer but shade and write pixels one at a time.");
+    QCommandLineOption immediateOpt("immediate", "Rasterize triangles directly instead of binning them into screen tiles.");
+    QCommandLineOption noCullingOpt("no-frustum-culling", "Submit every mesh even when its bounds are outside the view frustum.");
+    QCommandLineOption noMeshletCullingOpt("no-meshlet-culling", "Submit every triangle of a visible mesh instead of culling meshlets by frustum and normal cone.");
+    QCommandLineOption visibilityOpt("visibility-buffer", "Rasterize depth and triangle IDs only, then shade each visible pixel once.");
+    QCommandLineOption noMeshCacheOpt("no-mesh-cache", "Always import the model and do not write the binary mesh cache.");
+    QCommandLineOption meshOptOpt("mesh-opt", "Import-time mesh optimization: none, cache (weld + vertex cache order) or overdraw.", "kind", "overdraw");
+    QCommandLineOption assimpOpt("assimp", "Import OBJ files with Assimp instead of the native multithreaded parser.");
+    QCommandLineOption noTextureOpt("no-texture", "Disable texture sampling.");
+    QCommandLineOption layoutOpt("texture-layout", "Texel layout used when loading textures: tiled (4x4 blocks) or linear.", "kind", "tiled");
+    QCommandLineOption filterOpt("filter", "Texture filter: nearest, bilinear or trilinear (mipmapped).", "kind", "trilinear");
+    QCommandLineOption orbitOpt("orbit", "Rotate the camera around the model by this many degrees per frame.", "degrees", "0");
+    QCommandLineOption outputOpt({"o", "output"}, "Save the last frame, or every frame if the path contains %1.", "image");
+    QCommandLineOption statsOpt({"s", "stats"}, "Write per-frame timings as CSV.", "csv");
+    QCommandLineOption checkScalarOpt("check-scalar", "Re-render the last frame with the scalar reference path and fail if it differs by more than --tolerance.");
+    QCommandLineOption toleranceOpt("tolerance", "Largest allowed per-channel difference for --check-scalar.", "levels", "2");
+    QCommandLineOption pipelineStatsOpt("pipeline-stats", "Collect and print per-stage pipeline statistics.");
+    parser.addOptions({framesOpt, widthOpt, heightOpt, modeOpt, threadOpt, scalarOpt, scalarShadingOpt, immediateOpt,
+                       visibilityOpt, noCullingOpt, noMeshletCullingOpt, noTextureOpt, filterOpt, layoutOpt, noMeshCacheOpt, meshOptOpt, assimpOpt, orbitOpt, outputOpt, statsOpt, pipelineStatsOpt,
+                       checkScalarOpt, toleranceOpt});
+    parser.process(app);
+
+    const QStringList args = parser.positionalArguments();
+    if(args.size() != 1){
+        std::cerr << "exactly one model path is required" << std::endl;
+        return false;
+    }
+    opt.modelPath = args.at(0);
+    opt.frames = std::max(1, parser.value(framesOpt).toInt());
+    opt.width = std::max(1, parser.value(widthOpt).toInt());
+    opt.height = std::max(1, parser.value(heightOpt).toInt());
+    opt.orbitDegrees = parser.value(orbitOpt).toFloat();
+    opt.outputPath = parser.value(outputOpt);
+    opt.statsPath = parser.value(statsOpt);
+    opt.thread = parser.value(threadOpt);
+    opt.simd = !parser.isSet(scalarOpt);
+    opt.simdShading = !parser.isSet(scalarShadingOpt);
+    opt.tileBinning = !parser.isSet(immediateOpt);
+    opt.visibilityBuffer = parser.isSet(visibilityOpt);
+    opt.frustumCulling = !parser.isSet(noCullingOpt);
+    opt.meshletCulling = !parser.isSet(noMeshletCullingOpt);
+    opt.meshCache = !parser.isSet(noMeshCacheOpt);
+    opt.nativeObj = !parser.isSet(assimpOpt);
+    opt.checkScalar = parser.isSet(checkScalarOpt);
+    opt.tolerance = std::max(0, parser.value(toleranceOpt).toInt());
+    opt.pipelineStats = parser.isSet(pipelineStatsOpt);
+    SHADERTEXTURE = !parser.isSet(noTextureOpt);
+
+    const QString mode = parser.value(modeOpt);
+    if(mode == "raster"){
+        opt.mode = RendererMode::Rasterization;
+    }
+    else if(mode == "mesh"){
+        opt.mode = RendererMode::Mesh;
+    }
+    else if(mode == "vertex"){
+        opt.mode = RendererMode::VERTEX;
+    }
+    else{
+        std::cerr << "unknown render mode: " << mode.toStdString() << std::endl;
+        return false;
+    }
+    const QString filter = parser.value(filterOpt);
+    if(filter == "nearest"){
+        opt.textureFilter = TextureFilter::NEAREST;
+    }
+    else if(filter == "bilinear"){
+        opt.textureFilter = TextureFilter::BILINEAR;
+    }
+    else if(filter == "trilinear"){
+        opt.textureFilter = TextureFilter::TRILINEAR;
+    }
+    else{
+        std::cerr << "unknown texture filter: " << filter.toStdString() << std::endl;
+        return false;
+    }
+    const QString layout = parser.value(layoutOpt);
+    if(layout == "tiled"){
+        opt.textureLayout = TextureLayout::TILED;
+    }
+    else if(layout == "linear"){
+        opt.textureLayout = TextureLayout::LINEAR;
+    }
+    else{
+        std::cerr << "unknown texture layout: " << layout.toStdString() << std::endl;
+        return false;
+    }
+    const QString meshOpt = parser.value(meshOptOpt);
+    if(meshOpt == "none"){
+        opt.meshOptimization = MeshOptimization::NONE;
+    }
+    else if(meshOpt == "cache"){
+        opt.meshOptimization = MeshOptimization::VERTEX_CACHE;
+    }
+    else if(meshOpt == "overdraw"){
+        opt.meshOptimization = MeshOptimization::OVERDRAW;
+    }
+    else{
+        std::cerr << "unknown mesh optimization: " << meshOpt.toStdString() << std::endl;
+        return false;
+    }
+    if(opt.thread != "pool" && opt.thread != "tbb" && opt.thread != "single"){
+        std::cerr << "unknown thread kind: " << opt.thread.toStdString() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+static void applyOptions(SRendererDevice& renderDevice, const HeadlessOptions& opt)
+{
+    renderDevice.m_rendererMode = opt.mode;
+    renderDevice.m_simd = opt.simd;
+    renderDevice.m_simdShading = opt.simdShading;
+    renderDevice.m_multiThread = (opt.thread == "pool");
+    renderDevice.m_tbbThread = (opt.thread == "tbb");
+    renderDevice.m_tileBinning = opt.tileBinning;
+    renderDevice.m_visibilityBuffer = opt.visibilityBuffer;
+    renderDevice.m_frustumCulling = opt.frustumCulling;
+    renderDevice.m_meshletCulling = opt.meshletCulling;
+    renderDevice.m_textureFilter = opt.textureFilter;
+    renderDevice.m_textureLayout = opt.textureLayout;
+    renderDevice.m_pipelineStats = opt.pipelineStats;
+    renderDevice.resetPipelineStatistics();
+}
+
+// 逐像素比较两帧，返回最大单通道差值，并统计超出容差的像素数
+static int compareImages(const QImage& a, const QImage& b, int tolerance, long long& overTolerance)
+{
+    int maxDiff = 0;
+    overTolerance = 0;
+    for(int y = 0; y < a.height(); y++){
+        for(int x = 0; x < a.width(); x++){
+            QColor ca = a.pixelColor(x, y);
+            QColor cb = b.pixelColor(x, y);
+            int diff = std::max({std::abs(ca.red() - cb.red()),
+                                 std::abs(ca.green() - cb.green()),
+                                 std::abs(ca.blue() - cb.blue())});
+            maxDiff = std::max(maxDiff, diff);
+            overTolerance += diff > tolerance;
+        }
+    }
+    return maxDiff;
+}
+
+static QString framePath(const HeadlessOptions& opt, int frame)
+{
+    if(opt.outputPath.contains("%1")){
+        return opt.outputPath.arg(frame, 4, 10, QChar('0'));
+    }
+    return opt.outputPath;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv); // 仅用于命令行解析与图片插件路径，不创建窗口
+    HeadlessOptions opt;
+    if(!parseOptions(app, opt)){
+        return 1;
+    }
+
+    auto& renderDevice = initHeadlessDevice(opt.width, opt.height);
+    applyOptions(renderDevice, opt);
+
+    auto loadStart = std::chrono::steady_clock::now();
+    Model model(opt.modelPath, opt.meshCache, opt.nativeObj, opt.meshOptimization);
+    if(!model.m_loadSuccess){
+        return 1;
+    }
+    double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+    std::cout << "triangles: " << model.m_triangleCount << "  vertices: " << model.m_vertexCount
+              << "  load: " << loadMs << " ms" << std::endl;
+
+    Camera camera = makeHeadlessCamera(opt.width, opt.height, model);
+
+    std::vector<double> frameMs;
+    frameMs.reserve(opt.frames);
+    for(int frame = 0; frame < opt.frames; frame++){
+        if(opt.orbitDegrees != 0.f){
+            camera.rotateAroundTarget({opt.orbitDegrees / 360.f, 0.f});
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        renderHeadlessFrame(renderDevice, model, camera);
+        auto end = std::chrono::steady_clock::now();
+        frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+
+        bool lastFrame = (frame == opt.frames - 1);
+        if(!opt.outputPath.isEmpty() && (lastFrame || opt.outputPath.contains("%1"))){
+            if(!renderDevice.getBuffer().save(framePath(opt, frame))){
+                std::cerr << "failed to save frame " << frame << std::endl;
+            }
+        }
+    }
+
+    if(!opt.statsPath.isEmpty()){
+        std::ofstream stats(opt.statsPath.toStdString());
+        stats << "frame,ms\n";
+        for(size_t i = 0; i < frameMs.size(); i++){
+            stats << i << ',' << frameMs[i] << '\n';
+        }
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+    double avg = total / sorted.size();
+    std::cout << "frames: " << sorted.size()
+              << "  avg: " << avg << " ms"
+              << "  min: " << sorted.front() << " ms"
+              << "  p50: " << sorted[sorted.size() / 2] << " ms"
+              << "  p95: " << sorted[std::min(sorted.size() - 1, sorted.size() * 95 / 100)] << " ms"
+              << "  max: " << sorted.back() << " ms"
+              << "  fps: " << 1000.0 / avg << std::endl;
+    if(opt.pipelineStats){
+        printPipelineStatistics(renderDevice.getPipelineStatistics(), opt.frames);
+    }
+
+    if(opt.checkScalar){
+        // 标量光栅化 + 标量着色(前向着色)作为参考，与最后一帧做图像比较
+        QImage image = renderDevice.getBuffer().copy();
+        renderDevice.m_simd = false;
+        renderDevice.m_visibilityBuffer = false;
+        renderHeadlessFrame(renderDevice, model, camera);
+        long long overTolerance = 0;
+        int maxDiff = compareImages(image, renderDevice.getBuffer(), opt.tolerance, overTolerance);
+        std::cout << "scalar check: max channel diff " << maxDiff
+                  << "  pixels over tolerance " << overTolerance << std::endl;
+        if(maxDiff > opt.tolerance){
+            return 2;
+        }
+    }
+    return 0;
+}
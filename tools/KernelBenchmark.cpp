@@ -0,0 +1,432 @@
+// 内核级微基准测试：单独测量光栅化热点函数的标量与 AVX2 版本，输出每像素周期数
+// 用法示例：SoftRendererKernelBench --texture res/models/african_head/african_head_diffuse.png
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <thread>
+#include <x86intrin.h>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "HeadlessCommon.h"
+#include "HelperFunction.h"
+#include "TaskScheduler.h"
+#include "threadpool.h"
+
+bool SHADERTEXTURE = false;
+bool AMBIENT = false;
+bool DIFFUSE = false;
+bool SPECULAR = false;
+bool FXAA = false;
+
+// 测试区域：GRID_W x GRID_H 个像素，完全位于测试三角形内部
+static constexpr int GRID_W = 256;
+static constexpr int GRID_H = 64;
+static constexpr int GRID_PIXELS = GRID_W * GRID_H;
+
+volatile float g_sink = 0.f; // 防止编译器把被测结果优化掉
+
+struct KernelResult
+{
+    double cyclesPerPixel;
+    double nsPerPixel;
+};
+
+// 重复执行 body(处理完整个测试区域)，取最快一次；before 在计时外执行(如重置深度缓冲)
+template<class Before, class Body>
+static KernelResult measure(int reps, Before&& before, Body&& body)
+{
+    unsigned long long bestCycles = std::numeric_limits<unsigned long long>::max();
+    double bestNs = std::numeric_limits<double>::max();
+    for(int r = 0; r < reps; r++){
+        before();
+        auto start = std::chrono::steady_clock::now();
+        unsigned long long c0 = __rdtsc();
+        body();
+        unsigned long long c1 = __rdtsc();
+        auto end = std::chrono::steady_clock::now();
+        bestCycles = std::min(bestCycles, c1 - c0);
+        bestNs = std::min(bestNs, std::chrono::duration<double, std::nano>(end - start).count());
+    }
+    return {static_cast<double>(bestCycles) / GRID_PIXELS, bestNs / GRID_PIXELS};
+}
+
+template<class Body>
+static KernelResult measure(int reps, Body&& body)
+{
+    return measure(reps, []{}, std::forward<Body>(body));
+}
+
+static void report(const char* kernel, const KernelResult& scalar, const KernelResult& simd)
+{
+    std::cout << std::setw(16) << kernel
+              << std::setw(12) << scalar.cyclesPerPixel
+              << std::setw(12) << simd.cyclesPerPixel
+              << std::setw(12) << scalar.nsPerPixel
+              << std::setw(12) << simd.nsPerPixel
+              << std::setw(10) << scalar.cyclesPerPixel / simd.cyclesPerPixel << "x" << std::endl;
+}
+
+// 测量一次空 fork-join 的往返时间(微秒)，gapUs > 0 时两次派发之间先休眠，让工作线程进入休眠
+template<class Dispatch>
+static void reportDispatch(const char* name, int count, int gapUs, Dispatch&& dispatch)
+{
+    std::vector<double> us;
+    us.reserve(count);
+    for(int i = 0; i < count; i++){
+        if(gapUs > 0){
+            std::this_thread::sleep_for(std::chrono::microseconds(gapUs));
+        }
+        auto start = std::chrono::steady_clock::now();
+        dispatch();
+        us.push_back(std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count());
+    }
+    std::sort(us.begin(), us.end());
+    std::cout << std::setw(16) << name
+              << std::setw(12) << us[us.size() / 2]
+              << std::setw(12) << us[us.size() * 99 / 100]
+              << std::setw(12) << us.front() << std::endl;
+}
+
+// 构造一个覆盖测试区域的三角形(屏幕坐标、深度、1/w 与属性均已填好)
+static Triangle makeTestTriangle()
+{
+    Triangle tri;
+    const CoordI2D screen[3] = {{0, 0}, {GRID_W * 4, 0}, {0, GRID_H * 4}};
+    const float w[3] = {1.5f, 2.5f, 4.f};
+    for(int i = 0; i < 3; i++){
+        tri[i].screenPos = screen[i];
+        tri[i].screenDepth = 0.2f + 0.2f * i;
+        tri[i].clipSpacePos = Coord4D(0.f, 0.f, tri[i].screenDepth * w[i], w[i]);
+        tri[i].worldSpacePos = Coord3D(0.5f * i, 1.f - 0.3f * i, -0.25f * i);
+        tri[i].normal = glm::normalize(Vector3D(0.2f * i, 1.f, 0.5f));
+        tri[i].texCoord = Coord2D(0.1f + 0.4f * i, 0.8f - 0.3f * i);
+    }
+    return tri;
+}
+
+static __m256i laneX(int x)
+{
+    return _mm256_add_epi32(_mm256_set1_epi32(x), _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7));
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SoftRenderer SIMD kernel microbenchmarks");
+    parser.addHelpOption();
+    QCommandLineOption repsOpt({"r", "reps"}, "Repetitions per kernel (fastest is reported).", "count", "50");
+    QCommandLineOption textureOpt("texture", "Texture used by the sampling and shading kernels.", "image",
+                                  "res/models/african_head/african_head_diffuse.png");
+    parser.addOptions({repsOpt, textureOpt});
+    parser.process(app);
+    const int reps = std::max(1, parser.value(repsOpt).toInt());
+
+    auto& renderDevice = initHeadlessDevice(GRID_W, GRID_H);
+    Shader& shader = *renderDevice.m_shader;
+    shader.m_eyePos = Coord3D(0.f, 0.f, 3.f);
+
+    Texture texture;
+    bool hasTexture = texture.loadFromImage(parser.value(textureOpt));
+    if(hasTexture){
+        renderDevice.m_textureList = {texture};
+    }
+    else{
+        std::cout << "[warn] texture not loaded, sampling kernels skipped" << std::endl;
+    }
+
+    Triangle tri = makeTestTriangle();
+    EdgeEquation triEdge(tri);
+    EdgeEquationSimd triEdgeSimd(tri);
+    SRFrameBuffer frameBuffer(GRID_W, GRID_H);
+    const TexCoordGradient texGradient = getTexCoordGradient(tri);
+
+    // 预先计算各像素的边缘函数值、重心坐标与片元，保证每个内核单独计时
+    std::vector<VectorI3D> edgeValues(GRID_PIXELS);
+    std::vector<Vector3D> barycentrics(GRID_PIXELS);
+    std::vector<Fragment> fragments(GRID_PIXELS);
+    std::vector<SimdVectorI3D> edgeValuesSimd(GRID_PIXELS / 8);
+    std::vector<SimdVector3D> barycentricsSimd(GRID_PIXELS / 8);
+    std::vector<SimdFragment> fragmentsSimd(GRID_PIXELS / 8);
+    for(int y = 0; y < GRID_H; y++){
+        for(int x = 0; x < GRID_W; x++){
+            int idx = y * GRID_W + x;
+            edgeValues[idx] = triEdge.getResult(x, y);
+            barycentrics[idx] = triEdge.getBarycentric(edgeValues[idx]);
+            float z = calculateInterpolation<float>(tri[0].screenDepth, tri[1].screenDepth, tri[2].screenDepth, barycentrics[idx]);
+            float viewDepth = 1.f / (barycentrics[idx].x / tri[0].ndcSpacePos.w + barycentrics[idx].y / tri[1].ndcSpacePos.w + barycentrics[idx].z / tri[2].ndcSpacePos.w);
+            fragments[idx] = constructFragment(x, y, z, viewDepth, tri, barycentrics[idx]);
+            setTexCoordDerivatives(fragments[idx], texGradient, viewDepth);
+        }
+        for(int x = 0; x < GRID_W; x += 8){
+            int idx = (y * GRID_W + x) / 8;
+            __m256i simdY = _mm256_set1_epi32(y);
+            edgeValuesSimd[idx] = triEdgeSimd.getResultSimd(laneX(x), simdY);
+            barycentricsSimd[idx] = triEdgeSimd.getBarycentricSimd(edgeValuesSimd[idx]);
+            __m256 z = calculateInterpolationSimdFloat(tri[0].screenDepth, tri[1].screenDepth, tri[2].screenDepth, barycentricsSimd[idx]);
+            fragmentsSimd[idx] = constructFragmentSimd(laneX(x), simdY, z, barycentricsSimd[idx], tri);
+        }
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::setw(16) << "kernel"
+              << std::setw(12) << "scalar c/px" << std::setw(12) << "simd c/px"
+              << std::setw(12) << "scalar ns" << std::setw(12) << "simd ns"
+              << std::setw(11) << "speedup" << std::endl;
+
+    // 边缘函数 + 内部判定
+    KernelResult edgeScalar = measure(reps, [&]{
+        int inside = 0;
+        VectorI3D cy = triEdge.getResult(0, 0);
+        for(int y = 0; y < GRID_H; y++){
+            VectorI3D cx = cy;
+            for(int x = 0; x < GRID_W; x++){
+                inside += judgeInsideTriangle(triEdge, cx);
+                triEdge.upX(cx);
+            }
+            triEdge.upY(cy);
+        }
+        g_sink = g_sink + inside;
+    });
+    KernelResult edgeSimd = measure(reps, [&]{
+        __m256i inside = _mm256_setzero_si256();
+        for(int y = 0; y < GRID_H; y++){
+            __m256i simdY = _mm256_set1_epi32(y);
+            for(int x = 0; x < GRID_W; x += 8){
+                SimdVectorI3D val = triEdgeSimd.getResultSimd(laneX(x), simdY);
+                inside = _mm256_sub_epi32(inside, triEdgeSimd.judgeInsideTriangleSimd(val));
+            }
+        }
+        g_sink = g_sink + _mm256_extract_epi32(inside, 0);
+    });
+    report("edge+inside", edgeScalar, edgeSimd);
+
+    // 重心坐标插值(Vector3D 属性)
+    KernelResult interpScalar = measure(reps, [&]{
+        Vector3D acc(0.f);
+        for(int i = 0; i < GRID_PIXELS; i++){
+            acc += calculateInterpolation<Vector3D>(tri[0].normal, tri[1].normal, tri[2].normal, barycentrics[i]);
+        }
+        g_sink = g_sink + acc.x;
+    });
+    KernelResult interpSimd = measure(reps, [&]{
+        __m256 acc = _mm256_setzero_ps();
+        for(int i = 0; i < GRID_PIXELS / 8; i++){
+            SimdVector3D res = calculateInterpolationSimdVector3D(tri[0].normal, tri[1].normal, tri[2].normal, barycentricsSimd[i]);
+            acc = _mm256_add_ps(acc, res.x);
+        }
+        g_sink = g_sink + _mm256_cvtss_f32(acc);
+    });
+    report("interpolate3D", interpScalar, interpSimd);
+
+    // 片元构造(含透视校正属性)
+    KernelResult fragScalar = measure(reps, [&]{
+        float acc = 0.f;
+        for(int y = 0; y < GRID_H; y++){
+            for(int x = 0; x < GRID_W; x++){
+                const Vector3D& bary = barycentrics[y * GRID_W + x];
+                float viewDepth = 1.f / (bary.x / tri[0].ndcSpacePos.w + bary.y / tri[1].ndcSpacePos.w + bary.z / tri[2].ndcSpacePos.w);
+                Fragment frag = constructFragment(x, y, 0.5f, viewDepth, tri, bary);
+                acc += frag.texCoord.x;
+            }
+        }
+        g_sink = g_sink + acc;
+    });
+    KernelResult fragSimd = measure(reps, [&]{
+        __m256 acc = _mm256_setzero_ps();
+        __m256 z = _mm256_set1_ps(0.5f);
+        for(int y = 0; y < GRID_H; y++){
+            __m256i simdY = _mm256_set1_epi32(y);
+            for(int x = 0; x < GRID_W; x += 8){
+                SimdFragment frag = constructFragmentSimd(laneX(x), simdY, z, barycentricsSimd[(y * GRID_W + x) / 8], tri);
+                acc = _mm256_add_ps(acc, frag.texCoord.x);
+            }
+        }
+        g_sink = g_sink + _mm256_cvtss_f32(acc);
+    });
+    report("constructFrag", fragScalar, fragSimd);
+
+    // 深度测试(每次重复前重置深度缓冲，使所有像素都通过测试并写回)
+    auto resetDepth = [&]{ frameBuffer.clearBuffer(Color(0.f)); };
+    KernelResult depthScalar = measure(reps, resetDepth, [&]{
+        int passed = 0;
+        for(int y = 0; y < GRID_H; y++){
+            for(int x = 0; x < GRID_W; x++){
+                passed += frameBuffer.judgeDepth(x, y, fragments[y * GRID_W + x].screenDepth);
+            }
+        }
+        g_sink = g_sink + passed;
+    });
+    KernelResult depthSimd = measure(reps, resetDepth, [&]{
+        int passed = 0;
+        __m256 allInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for(int i = 0; i < GRID_PIXELS / 8; i++){
+            const SimdFragment& frag = fragmentsSimd[i];
+            passed += _mm256_movemask_ps(frameBuffer.judgeDepthSimd(allInside, frag.screenPosX, frag.screenPosY, frag.screenDepth));
+        }
+        g_sink = g_sink + passed;
+    });
+    report("depthTest", depthScalar, depthSimd);
+
+    // 像素写入(以重心坐标作为颜色)
+    KernelResult writeScalar = measure(reps, [&]{
+        for(int y = 0; y < GRID_H; y++){
+            for(int x = 0; x < GRID_W; x++){
+                frameBuffer.setPixel(x, y, barycentrics[y * GRID_W + x]);
+            }
+        }
+        g_sink = g_sink + frameBuffer.getColorData()[0];
+    });
+    KernelResult writeSimd = measure(reps, [&]{
+        __m256 allInside = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+        for(int i = 0; i < GRID_PIXELS / 8; i++){
+            const SimdVector3D& b = barycentricsSimd[i];
+            frameBuffer.setPixelSIMD(fragmentsSimd[i].screenPosX, fragmentsSimd[i].screenPosY, {b.x, b.y, b.z}, allInside);
+        }
+        g_sink = g_sink + frameBuffer.getColorData()[0];
+    });
+    report("setPixel", writeScalar, writeSimd);
+
+    // 纹理采样
+    if(hasTexture){
+        KernelResult texScalar = measure(reps, [&]{
+            Color acc(0.f);
+            for(int i = 0; i < GRID_PIXELS; i++){
+                acc += texture.sample2D(fragments[i].texCoord);
+            }
+            g_sink = g_sink + acc.x;
+        });
+        KernelResult texSimd = measure(reps, [&]{
+            __m256 acc = _mm256_setzero_ps();
+            for(int i = 0; i < GRID_PIXELS / 8; i++){
+                __m256 w = _mm256_rcp_ps(fragmentsSimd[i].viewDepth);
+                SimdVector2D uv = {_mm256_mul_ps(fragmentsSimd[i].texCoord.x, w), _mm256_mul_ps(fragmentsSimd[i].texCoord.y, w)};
+                acc = _mm256_add_ps(acc, texture.simdSample2D(uv).r);
+            }
+            g_sink = g_sink + _mm256_cvtss_f32(acc);
+        });
+        report("sample2D", texScalar, texSimd);
+
+        // 三线性过滤：由屏幕空间导数选择 mip 层级，两层各做一次双线性
+        std::vector<SimdFragment> filteredSimd = fragmentsSimd;
+        for(auto& frag : filteredSimd){
+            correctPerspectiveSimd(frag);
+            setTexCoordDerivativesSimd(frag, texGradient);
+        }
+        // 分块布局(默认)与行主序布局各测一次
+        Texture linearTexture;
+        linearTexture.loadFromImage(parser.value(textureOpt), TextureLayout::LINEAR);
+        for(Texture* filtered : {&texture, &linearTexture}){
+            KernelResult trilinearScalar = measure(reps, [&]{
+                Color acc(0.f);
+                for(int i = 0; i < GRID_PIXELS; i++){
+                    acc += filtered->sample2D(fragments[i].texCoord, fragments[i].texCoordDx, fragments[i].texCoordDy, TextureFilter::TRILINEAR);
+                }
+                g_sink = g_sink + acc.x;
+            });
+            KernelResult trilinearSimd = measure(reps, [&]{
+                __m256 acc = _mm256_setzero_ps();
+                for(int i = 0; i < GRID_PIXELS / 8; i++){
+                    const SimdFragment& frag = filteredSimd[i];
+                    acc = _mm256_add_ps(acc, filtered->simdSample2D(frag.texCoord, frag.texCoordDx, frag.texCoordDy, TextureFilter::TRILINEAR).r);
+                }
+                g_sink = g_sink + _mm256_cvtss_f32(acc);
+            });
+            report(filtered == &texture ? "sample2D-tri" : "sample2D-tri-lin", trilinearScalar, trilinearSimd);
+        }
+    }
+
+    // Blinn-Phong 片元着色(不采样纹理 / 采样漫反射纹理)，SIMD 着色器的输入须已完成透视校正
+    std::vector<SimdFragment> correctedSimd = fragmentsSimd;
+    for(auto& frag : correctedSimd){
+        correctPerspectiveSimd(frag);
+        setTexCoordDerivativesSimd(frag, texGradient);
+    }
+    for(int textured = 0; textured <= (hasTexture ? 1 : 0); textured++){
+        SHADERTEXTURE = (textured == 1);
+        shader.m_material.diffuse = textured ? 0 : -1;
+        shader.m_material.specular = -1;
+        KernelResult shadeScalar = measure(reps, [&]{
+            float acc = 0.f;
+            for(int i = 0; i < GRID_PIXELS; i++){
+                Fragment frag = fragments[i];
+                shader.fragmentShader(frag);
+                acc += frag.fragmentColor.x;
+            }
+            g_sink = g_sink + acc;
+        });
+        KernelResult shadeSimd = measure(reps, [&]{
+            __m256 acc = _mm256_setzero_ps();
+            __m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+            for(int i = 0; i < GRID_PIXELS / 8; i++){
+                SimdFragment frag = correctedSimd[i];
+                shader.fragmentShaderSIMD(frag, mask);
+                acc = _mm256_add_ps(acc, frag.fragmentColor.r);
+            }
+            g_sink = g_sink + _mm256_cvtss_f32(acc);
+        });
+        report(textured ? "shade+texture" : "shade", shadeScalar, shadeSimd);
+    }
+
+    // 派发延迟：每个线程一个空任务，比较 ThreadPool(packaged_task + future) 与工作窃取调度器；
+    // parked 一行在两次派发间休眠 1ms，工作线程已停止自旋，测的是从条件变量唤醒的代价
+    const int threads = static_cast<int>(std::max(2u, std::thread::hardware_concurrency()));
+    std::cout << "\ndispatch latency, " << threads << " threads (us)" << std::endl;
+    std::cout << std::setw(16) << "path" << std::setw(12) << "p50" << std::setw(12) << "p99" << std::setw(12) << "min" << std::endl;
+    std::atomic<int> touched{0};
+    {
+        ThreadPool pool(threads, threads);
+        std::vector<std::future<void>> futures;
+        reportDispatch("pool-future", 2000, 0, [&]{
+            futures.clear();
+            for(int t = 0; t < threads; t++){
+                futures.push_back(pool.addTask([&touched]{ touched++; }));
+            }
+            for(auto& future : futures){
+                future.get();
+            }
+        });
+    }
+    {
+        TaskScheduler scheduler(threads);
+        auto body = [&touched](int begin, int end){ touched += end - begin; };
+        reportDispatch("steal-hot", 2000, 0, [&]{ scheduler.parallelFor(0, threads, body, 1); });
+        reportDispatch("steal-parked", 200, 1000, [&]{ scheduler.parallelFor(0, threads, body, 1); });
+    }
+    {
+        // 经过设备的同一次小绘制(两个顶点块、每线程 64 个被整体剔除的三角形)：顶点与三角形两个阶段各派发一次，
+        // 与单线程执行之差即为 parallelExecute 两次 fork-join 的开销
+        std::vector<Vertex> vertices(2 * VERTEX_BLOCK_SIZE);
+        for(Vertex& vertex : vertices){
+            vertex.worldSpacePos = Coord3D(0.f, 0.f, 5.f); // 位于视景体外
+        }
+        std::vector<unsigned> indices(3 * 64 * threads);
+        for(size_t i = 0; i < indices.size(); i++){
+            indices[i] = static_cast<unsigned>(i % vertices.size());
+        }
+        const BufferHandle vertexBuffer = renderDevice.createVertexBuffer(std::move(vertices));
+        const BufferHandle indexBuffer = renderDevice.createIndexBuffer(std::move(indices));
+        shader.m_modelTransformation = glm::mat4(1.f);
+        shader.m_viewTransformation = glm::mat4(1.f);
+        shader.m_projectionTransformation = glm::mat4(1.f);
+        renderDevice.m_rendererMode = RendererMode::Rasterization;
+        renderDevice.m_tileBinning = false;
+        renderDevice.m_visibilityBuffer = false;
+        renderDevice.m_threadCount = threads;
+        auto draw = [&]{
+            renderDevice.bindVertexBuffer(vertexBuffer);
+            renderDevice.cullMeshlets({}, indexBuffer);
+            renderDevice.render();
+        };
+        renderDevice.m_multiThread = false;
+        reportDispatch("device-single", 2000, 0, draw);
+        renderDevice.m_multiThread = true;
+        reportDispatch("device-steal", 2000, 0, draw);
+        renderDevice.releaseVertexBuffer(vertexBuffer);
+        renderDevice.releaseIndexBuffer(indexBuffer);
+    }
+    g_sink = g_sink + touched.load();
+    return 0;
+}
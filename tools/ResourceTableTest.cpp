@@ -0,0 +1,60 @@
+// 设备资源表测试：重复释放同一句柄不能让之后的两次创建得到同一个位置
+// 用法：SoftRendererResourceTest，全部通过时返回 0
+#include <iostream>
+#include "SRendererDevice.h"
+
+static int g_failures = 0;
+
+static void check(bool condition, const char* message)
+{
+    if(!condition){
+        std::cerr << "FAILED: " << message << std::endl;
+        g_failures++;
+    }
+}
+
+static void testVertexBufferDoubleRelease(SRendererDevice& device)
+{
+    BufferHandle handle = device.createVertexBuffer(std::vector<Vertex>(3));
+    device.releaseVertexBuffer(handle);
+    device.releaseVertexBuffer(handle);
+    BufferHandle first = device.createVertexBuffer(std::vector<Vertex>(3));
+    BufferHandle second = device.createVertexBuffer(std::vector<Vertex>(3));
+    check(first == handle, "vertex buffer: released handle is reused");
+    check(first != second, "vertex buffer: double release hands out the same handle twice");
+    device.releaseVertexBuffer(first);
+    device.releaseVertexBuffer(second);
+}
+
+static void testIndexBufferDoubleRelease(SRendererDevice& device)
+{
+    BufferHandle handle = device.createIndexBuffer({0, 1, 2});
+    device.releaseIndexBuffer(handle);
+    device.releaseIndexBuffer(handle);
+    BufferHandle first = device.createIndexBuffer({0, 1, 2});
+    BufferHandle second = device.createIndexBuffer({0, 1, 2});
+    check(first != second, "index buffer: double release hands out the same handle twice");
+    device.releaseIndexBuffer(first);
+    device.releaseIndexBuffer(second);
+}
+
+static void testInvalidRelease(SRendererDevice& device)
+{
+    device.releaseVertexBuffer(INVALID_BUFFER);
+    device.releaseVertexBuffer(1 << 20); // 从未创建过的句柄
+    BufferHandle first = device.createVertexBuffer(std::vector<Vertex>(3));
+    BufferHandle second = device.createVertexBuffer(std::vector<Vertex>(3));
+    check(first >= 0 && second >= 0 && first != second, "vertex buffer: releasing an invalid handle corrupts the free list");
+}
+
+int main()
+{
+    SRendererDevice device(64, 64);
+    testVertexBufferDoubleRelease(device);
+    testIndexBufferDoubleRelease(device);
+    testInvalidRelease(device);
+    if(g_failures == 0){
+        std::cout << "all resource table tests passed" << std::endl;
+    }
+    return g_failures == 0 ? 0 : 1;
+}
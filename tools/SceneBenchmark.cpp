@@ -0,0 +1,236 @@
+// 端到端基准测试：以固定相机位姿渲染 res/models 下的各个模型，
+// 覆盖标量/SIMD 光栅化、线程池/TBB 分发以及线框、顶点模式，并给出线程数加速曲线
+// 用法示例：SoftRendererBenchmark --models res/models -n 20 --csv bench.csv
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+#include <QDir>
+#include <QFileInfo>
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include "tbb/global_control.h"
+#include "HeadlessCommon.h"
+
+bool SHADERTEXTURE = true;
+bool AMBIENT = false;
+bool DIFFUSE = false;
+bool SPECULAR = false;
+bool FXAA = false;
+
+// 仓库自带的模型(目录名)
+static const char* BENCH_MODELS[] = {
+    "african_head", "nanosuit", "Kara", "AdaWong",
+    "Alcina_Dimitrescu", "City", "house", "backpack"
+};
+
+// 固定相机位姿：绕模型中心的水平旋转角(度)
+static const float BENCH_POSES[] = {0.f, 120.f, 240.f};
+
+enum class Dispatch
+{
+    SINGLE,
+    POOL,
+    TBB
+};
+
+struct BenchPath
+{
+    const char* name;
+    RendererMode mode;
+    bool simd;
+    Dispatch dispatch;
+    bool tiled; // 分块(sort-middle)光栅化
+    bool visibility{false}; // 可见性缓冲：先光栅化 ID，帧末统一着色
+};
+
+static const BenchPath BENCH_PATHS[] = {
+    {"raster-scalar-single",        RendererMode::Rasterization,  false, Dispatch::SINGLE, true},
+    {"raster-simd-single",          RendererMode::Rasterization,  true,  Dispatch::SINGLE, true},
+    {"raster-scalar-pool",          RendererMode::Rasterization,  false, Dispatch::POOL,   true},
+    {"raster-simd-pool",            RendererMode::Rasterization,  true,  Dispatch::POOL,   true},
+    {"raster-scalar-tbb",           RendererMode::Rasterization,  false, Dispatch::TBB,    true},
+    {"raster-simd-tbb",             RendererMode::Rasterization,  true,  Dispatch::TBB,    true},
+    {"raster-simd-pool-immediate",  RendererMode::Rasterization,  true,  Dispatch::POOL,   false},
+    {"raster-simd-tbb-immediate",   RendererMode::Rasterization,  true,  Dispatch::TBB,    false},
+    {"raster-simd-single-visbuf",   RendererMode::Rasterization,  true,  Dispatch::SINGLE, true,  true},
+    {"raster-simd-pool-visbuf",     RendererMode::Rasterization,  true,  Dispatch::POOL,   true,  true},
+    {"raster-simd-tbb-visbuf",      RendererMode::Rasterization,  true,  Dispatch::TBB,    true,  true},
+    {"mesh-pool",                   RendererMode::Mesh,           false, Dispatch::POOL,   false},
+    {"vertex-pool",                 RendererMode::VERTEX,         false, Dispatch::POOL,   false},
+};
+
+struct BenchResult
+{
+    double msPerFrame;      // 每帧耗时中位数
+    double trianglesPerSec; // 每秒提交的三角形数
+    double fragmentsPerSec; // 每秒着色的片元数(来自管线统计)
+};
+
+static QString findModelFile(const QString& dir)
+{
+    QDir modelDir(dir);
+    QStringList objs = modelDir.entryList({"*.obj"}, QDir::Files, QDir::Name);
+    if(objs.isEmpty()){
+        return {};
+    }
+    return modelDir.filePath(objs.first());
+}
+
+static void applyPath(SRendererDevice& renderDevice, const BenchPath& path, int threads)
+{
+    renderDevice.m_rendererMode = path.mode;
+    renderDevice.m_simd = path.simd;
+    renderDevice.m_multiThread = (path.dispatch == Dispatch::POOL);
+    renderDevice.m_tbbThread = (path.dispatch == Dispatch::TBB);
+    renderDevice.m_tileBinning = path.tiled;
+    renderDevice.m_visibilityBuffer = path.visibility;
+    renderDevice.m_threadCount = threads;
+}
+
+// 额外渲染一帧(不计时)并开启管线统计，得到该位姿下一帧着色的片元数
+static unsigned long long countShadedFragments(SRendererDevice& renderDevice, Model& model, Camera& camera)
+{
+    renderDevice.resetPipelineStatistics();
+    renderDevice.m_pipelineStats = true;
+    renderHeadlessFrame(renderDevice, model, camera);
+    renderDevice.m_pipelineStats = false;
+    return renderDevice.getPipelineStatistics().fragmentsShaded;
+}
+
+static BenchResult runBench(SRendererDevice& renderDevice, Model& model, Camera camera,
+                            const BenchPath& path, int threads, int warmup, int frames)
+{
+    applyPath(renderDevice, path, threads);
+    // TBB 的并行度通过 global_control 限制；工作窃取调度器按 m_threadCount 重建为对应线程数
+    size_t tbbThreads = threads > 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+    tbb::global_control tbbLimit(tbb::global_control::max_allowed_parallelism, tbbThreads);
+
+    std::vector<double> frameMs;
+    unsigned long long fragments = 0;
+    for(float yaw : BENCH_POSES){
+        Camera poseCamera = camera;
+        poseCamera.rotateAroundTarget({yaw / 360.f, 0.f});
+        for(int i = 0; i < warmup; i++){
+            renderHeadlessFrame(renderDevice, model, poseCamera);
+        }
+        for(int i = 0; i < frames; i++){
+            auto start = std::chrono::steady_clock::now();
+            renderHeadlessFrame(renderDevice, model, poseCamera);
+            auto end = std::chrono::steady_clock::now();
+            frameMs.push_back(std::chrono::duration<double, std::milli>(end - start).count());
+        }
+        fragments += countShadedFragments(renderDevice, model, poseCamera) * frames;
+    }
+
+    std::vector<double> sorted = frameMs;
+    std::sort(sorted.begin(), sorted.end());
+    double total = 0.0;
+    for(double ms : frameMs){
+        total += ms;
+    }
+    double seconds = total / 1000.0;
+    BenchResult res;
+    res.msPerFrame = sorted[sorted.size() / 2];
+    res.trianglesPerSec = static_cast<double>(model.m_triangleCount) * frameMs.size() / seconds;
+    res.fragmentsPerSec = static_cast<double>(fragments) / seconds;
+    return res;
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCommandLineParser parser;
+    parser.setApplicationDescription("SoftRenderer end-to-end scene benchmark");
+    parser.addHelpOption();
+    QCommandLineOption modelsOpt("models", "Directory holding one sub-directory per model.", "dir", "res/models");
+    QCommandLineOption onlyOpt("only", "Only benchmark this model (directory name).", "name");
+    QCommandLineOption framesOpt({"n", "frames"}, "Measured frames per camera pose.", "count", "10");
+    QCommandLineOption warmupOpt("warmup", "Unmeasured frames per camera pose.", "count", "2");
+    QCommandLineOption widthOpt({"W", "width"}, "Frame buffer width.", "pixels", "800");
+    QCommandLineOption heightOpt({"H", "height"}, "Frame buffer height.", "pixels", "600");
+    QCommandLineOption maxThreadsOpt("max-threads", "Upper end of the thread scaling curve.", "count");
+    QCommandLineOption noScalingOpt("no-scaling", "Skip the thread scaling curve.");
+    QCommandLineOption csvOpt("csv", "Also write results as CSV.", "file");
+    parser.addOptions({modelsOpt, onlyOpt, framesOpt, warmupOpt, widthOpt, heightOpt,
+                       maxThreadsOpt, noScalingOpt, csvOpt});
+    parser.process(app);
+
+    const int frames = std::max(1, parser.value(framesOpt).toInt());
+    const int warmup = std::max(0, parser.value(warmupOpt).toInt());
+    const int width = std::max(1, parser.value(widthOpt).toInt());
+    const int height = std::max(1, parser.value(heightOpt).toInt());
+    int maxThreads = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+    if(parser.isSet(maxThreadsOpt)){
+        maxThreads = std::max(1, parser.value(maxThreadsOpt).toInt());
+    }
+
+    auto& renderDevice = initHeadlessDevice(width, height);
+
+    std::ofstream csv;
+    if(parser.isSet(csvOpt)){
+        csv.open(parser.value(csvOpt).toStdString());
+        csv << "model,path,threads,ms_per_frame,triangles_per_s,fragments_per_s,speedup\n";
+    }
+
+    std::cout << std::fixed << std::setprecision(2);
+    for(const char* name : BENCH_MODELS){
+        if(parser.isSet(onlyOpt) && parser.value(onlyOpt) != name){
+            continue;
+        }
+        QString modelFile = findModelFile(QDir(parser.value(modelsOpt)).filePath(name));
+        if(modelFile.isEmpty()){
+            std::cout << "[skip] " << name << ": no .obj found" << std::endl;
+            continue;
+        }
+
+        Model model(modelFile);
+        if(!model.m_loadSuccess){
+            std::cout << "[skip] " << name << ": load failed" << std::endl;
+            continue;
+        }
+        Camera camera = makeHeadlessCamera(width, height, model);
+        std::cout << "== " << name << "  triangles: " << model.m_triangleCount
+                  << "  vertices: " << model.m_vertexCount << std::endl;
+
+        for(const BenchPath& path : BENCH_PATHS){
+            BenchResult res = runBench(renderDevice, model, camera, path, 0, warmup, frames);
+            std::cout << std::setw(28) << path.name
+                      << std::setw(10) << res.msPerFrame << " ms/frame"
+                      << std::setw(10) << res.trianglesPerSec / 1e6 << " Mtri/s"
+                      << std::setw(10) << res.fragmentsPerSec / 1e6 << " Mfrag/s" << std::endl;
+            if(csv.is_open()){
+                csv << name << ',' << path.name << ",0," << res.msPerFrame << ','
+                    << res.trianglesPerSec << ',' << res.fragmentsPerSec << ",\n";
+            }
+        }
+
+        if(parser.isSet(noScalingOpt)){
+            continue;
+        }
+        // 线程数加速曲线(SIMD 光栅化路径)
+        for(const BenchPath& path : BENCH_PATHS){
+            if(path.mode != RendererMode::Rasterization || !path.simd || path.dispatch == Dispatch::SINGLE){
+                continue;
+            }
+            double baseMs = 0.0;
+            std::cout << std::setw(28) << path.name << " scaling:";
+            for(int threads = 1; threads <= maxThreads; threads++){
+                BenchResult res = runBench(renderDevice, model, camera, path, threads, warmup, frames);
+                if(threads == 1){
+                    baseMs = res.msPerFrame;
+                }
+                double speedup = baseMs / res.msPerFrame;
+                std::cout << "  " << threads << "T " << speedup << "x";
+                if(csv.is_open()){
+                    csv << name << ',' << path.name << ',' << threads << ',' << res.msPerFrame << ','
+                        << res.trianglesPerSec << ',' << res.fragmentsPerSec << ',' << speedup << '\n';
+                }
+            }
+            std::cout << std::endl;
+        }
+    }
+    return 0;
+}